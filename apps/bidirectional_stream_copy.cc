@@ -19,6 +19,14 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
   ByteStream inbound { buffer_size };
   bool outbound_shutdown { false };
   bool inbound_shutdown { false };
+  bool outbound_full { false };
+  bool inbound_full { false };
+
+  // Pause a source at a full stream and resume at half full, so each read has half the buffer to fill
+  outbound.set_watermarks(
+    buffer_size / 2, buffer_size, [&] { outbound_full = false; }, [&] { outbound_full = true; } );
+  inbound.set_watermarks(
+    buffer_size / 2, buffer_size, [&] { inbound_full = false; }, [&] { inbound_full = true; } );
 
   socket.set_blocking( false );
   input.set_blocking( false );
@@ -30,17 +38,10 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     input,
     Direction::In,
     [&] {
-      string data;
-      data.resize( outbound.writer().available_capacity() );
-      input.read( data );
-      outbound.writer().push( move( data ) );
-      if ( input.eof() ) {
-        outbound.writer().close();
-      }
+      outbound.writer().read_from( input );
     },
     [&] {
-      return !outbound.has_error() and !inbound.has_error() and ( outbound.writer().available_capacity() > 0 )
-             and !outbound.writer().is_closed();
+      return !outbound.has_error() and !inbound.has_error() and !outbound_full and !outbound.writer().is_closed();
     },
     [&] { outbound.writer().close(); },
     [&] {
@@ -55,9 +56,7 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     socket,
     Direction::Out,
     [&] {
-      if ( outbound.reader().bytes_buffered() ) {
-        outbound.reader().pop( socket.write( outbound.reader().peek() ) );
-      }
+      outbound.reader().write_to( socket );
       if ( outbound.reader().is_finished() ) {
         socket.shutdown( SHUT_WR );
         outbound_shutdown = true;
@@ -80,17 +79,10 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     socket,
     Direction::In,
     [&] {
-      string data;
-      data.resize( inbound.writer().available_capacity() );
-      socket.read( data );
-      inbound.writer().push( move( data ) );
-      if ( socket.eof() ) {
-        inbound.writer().close();
-      }
+      inbound.writer().read_from( socket );
     },
     [&] {
-      return !inbound.has_error() and !outbound.has_error() and ( inbound.writer().available_capacity() > 0 )
-             and !inbound.writer().is_closed();
+      return !inbound.has_error() and !outbound.has_error() and !inbound_full and !inbound.writer().is_closed();
     },
     [&] { inbound.writer().close(); },
     [&] {
@@ -105,9 +97,7 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     output,
     Direction::Out,
     [&] {
-      if ( inbound.reader().bytes_buffered() ) {
-        inbound.reader().pop( output.write( inbound.reader().peek() ) );
-      }
+      inbound.reader().write_to( output );
       if ( inbound.reader().is_finished() ) {
         output.close();
         inbound_shutdown = true;
@@ -11,6 +11,11 @@ macro (ttest name)
   set_property(TEST ${name} PROPERTY FIXTURES_REQUIRED compile)
 endmacro (ttest)
 
+macro (ttest_unsanitized name)
+  add_test(NAME ${name} COMMAND "${name}")
+  set_property(TEST ${name} PROPERTY FIXTURES_REQUIRED compile)
+endmacro (ttest_unsanitized)
+
 set_property(TEST ${compile_name} PROPERTY TIMEOUT 0)
 set_tests_properties(${compile_name} PROPERTIES FIXTURES_SETUP compile)
 
@@ -23,6 +28,9 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_spsc)
+ttest(byte_stream_fd)
+ttest_unsanitized(byte_stream_heap)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,12 +39,19 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_storage)
+ttest(reassembler_batch)
+ttest(reassembler_stats)
+ttest(reassembler_sack)
+ttest(reassembler_prune)
+ttest(reassembler_slices)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
 ttest(wrapping_integers_unwrap)
 ttest(wrapping_integers_roundtrip)
 ttest(wrapping_integers_extra)
+ttest(wrapping_integers_batch)
 
 ttest(recv_connect)
 ttest(recv_transmit)
@@ -45,6 +60,8 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_budget)
+ttest(recv_fast_path)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +70,10 @@ ttest(send_ack)
 ttest(send_close)
 ttest(send_retx)
 ttest(send_extra)
+ttest(send_congestion)
+ttest(send_cubic)
+ttest(send_pacing)
+ttest(send_fast_retransmit)
 
 ttest(net_interface)
 
@@ -94,3 +115,17 @@ set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
 stest(reassembler_speed_test)
+
+# The benchmarks report measurements rather than pass or fail, so they are run on demand through these
+# targets instead of being registered with ctest
+add_custom_target (bench_byte_stream COMMAND "${CMAKE_BINARY_DIR}/tests/byte_stream_benchmark"
+  DEPENDS byte_stream_benchmark)
+
+add_custom_target (bench_reassembler COMMAND "${CMAKE_BINARY_DIR}/tests/reassembler_benchmark"
+  DEPENDS reassembler_benchmark)
+
+add_custom_target (bench_wrapping_integers COMMAND "${CMAKE_BINARY_DIR}/tests/wrapping_integers_benchmark"
+  DEPENDS wrapping_integers_benchmark)
+
+add_custom_target (bench_congestion COMMAND "${CMAKE_BINARY_DIR}/tests/congestion_benchmark"
+  DEPENDS congestion_benchmark)
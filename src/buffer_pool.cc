@@ -0,0 +1,100 @@
+#include "buffer_pool.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+BufferPool::BufferPool( size_t page_size, size_t max_cached_pages )
+  : page_size_( page_size ), max_cached_pages_( max_cached_pages )
+{
+  if ( page_size_ == 0 ) {
+    throw runtime_error( "BufferPool page size must be positive" );
+  }
+}
+
+BufferPool::Page BufferPool::acquire()
+{
+  unique_ptr<char[]> data;
+  {
+    const lock_guard lock { mutex_ };
+    if ( !free_pages_.empty() ) {
+      data = move( free_pages_.back() );
+      free_pages_.pop_back();
+    }
+    pages_high_water_ = max( pages_high_water_, ++pages_in_use_ );
+  }
+  if ( !data ) {
+    data = make_unique_for_overwrite<char[]>( page_size_ );
+  }
+  return { this, move( data ) };
+}
+
+void BufferPool::give_back( unique_ptr<char[]> data )
+{
+  const lock_guard lock { mutex_ };
+  --pages_in_use_;
+  if ( free_pages_.size() < max_cached_pages_ ) {
+    free_pages_.push_back( move( data ) );
+  }
+}
+
+size_t BufferPool::pages_in_use() const
+{
+  const lock_guard lock { mutex_ };
+  return pages_in_use_;
+}
+
+size_t BufferPool::pages_high_water() const
+{
+  const lock_guard lock { mutex_ };
+  return pages_high_water_;
+}
+
+size_t BufferPool::pages_cached() const
+{
+  const lock_guard lock { mutex_ };
+  return free_pages_.size();
+}
+
+BufferPool::Page::Page( BufferPool* pool, unique_ptr<char[]> data ) : pool_( pool ), data_( move( data ) ) {}
+
+BufferPool::Page::Page( const Page& other )
+{
+  if ( other.data_ ) {
+    *this = other.pool_->acquire();
+    copy_n( other.data_.get(), pool_->page_size(), data_.get() );
+  }
+}
+
+BufferPool::Page& BufferPool::Page::operator=( const Page& other )
+{
+  if ( this != &other ) {
+    *this = Page { other };
+  }
+  return *this;
+}
+
+BufferPool::Page::Page( Page&& other ) noexcept : pool_( other.pool_ ), data_( move( other.data_ ) ) {}
+
+BufferPool::Page& BufferPool::Page::operator=( Page&& other ) noexcept
+{
+  if ( this != &other ) {
+    release();
+    pool_ = other.pool_;
+    data_ = move( other.data_ );
+  }
+  return *this;
+}
+
+BufferPool::Page::~Page()
+{
+  release();
+}
+
+void BufferPool::Page::release()
+{
+  if ( data_ ) {
+    pool_->give_back( move( data_ ) );
+  }
+}
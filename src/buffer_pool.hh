@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*
+ * BufferPool: hands out fixed-size pages of memory for ByteStream storage.
+ *
+ * A ByteStream built on a pool (ByteStream::Storage::Paged) takes pages only as bytes are pushed and
+ * gives them back as they are popped, so the memory held by many mostly-idle streams follows the
+ * bytes actually buffered rather than their configured capacities. Returned pages are cached for
+ * reuse, up to `max_cached_pages`; beyond that they are freed.
+ *
+ * A pool may be shared by streams on different threads.
+ */
+class BufferPool
+{
+public:
+  static constexpr size_t DEFAULT_PAGE_SIZE = 4096;
+  static constexpr size_t DEFAULT_MAX_CACHED_PAGES = 1024;
+
+  explicit BufferPool( size_t page_size = DEFAULT_PAGE_SIZE, size_t max_cached_pages = DEFAULT_MAX_CACHED_PAGES );
+
+  // A page borrowed from the pool, returned automatically when destroyed.
+  // Copying a Page takes a fresh page from the same pool and copies the contents.
+  class Page
+  {
+  public:
+    Page() = default;
+    Page( const Page& other );
+    Page& operator=( const Page& other );
+    Page( Page&& other ) noexcept;
+    Page& operator=( Page&& other ) noexcept;
+    ~Page();
+
+    char* data() { return data_.get(); }
+    const char* data() const { return data_.get(); }
+
+  private:
+    friend class BufferPool;
+    Page( BufferPool* pool, std::unique_ptr<char[]> data );
+    void release();
+
+    BufferPool* pool_ {}; // the pool outlives its pages (streams keep a shared_ptr to it)
+    std::unique_ptr<char[]> data_ {};
+  };
+
+  Page acquire();
+
+  size_t page_size() const { return page_size_; }
+  size_t pages_in_use() const;     // Pages currently lent out
+  size_t pages_high_water() const; // Most pages ever lent out at once
+  size_t pages_cached() const;     // Returned pages kept for reuse
+  uint64_t bytes_in_use() const { return pages_in_use() * page_size_; }
+
+  // Every Page it lends out points back to it, to be returned there: a pool stays put and outlives its pages
+  BufferPool( const BufferPool& other ) = delete;
+  BufferPool& operator=( const BufferPool& other ) = delete;
+  BufferPool( BufferPool&& other ) = delete;
+  BufferPool& operator=( BufferPool&& other ) = delete;
+  ~BufferPool() = default;
+
+private:
+  void give_back( std::unique_ptr<char[]> data );
+
+  size_t page_size_;
+  size_t max_cached_pages_;
+  mutable std::mutex mutex_ {};
+  std::vector<std::unique_ptr<char[]>> free_pages_ {};
+  size_t pages_in_use_ {};
+  size_t pages_high_water_ {};
+};
@@ -1,15 +1,177 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <stdexcept>
+
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
+ByteStream::ByteStream( uint64_t capacity, Storage storage ) : capacity_( capacity ), storage_( storage )
+{
+  if ( storage_ == Storage::Paged )
+    throw runtime_error( "ByteStream: paged storage needs a BufferPool" );
+}
+
+ByteStream::ByteStream( uint64_t capacity, shared_ptr<BufferPool> pool )
+  : capacity_( capacity ), storage_( Storage::Paged ), pool_( move( pool ) )
+{
+  if ( !pool_ )
+    throw runtime_error( "ByteStream: paged storage needs a BufferPool" );
+}
+
+void ByteStream::set_memory_budget( shared_ptr<MemoryBudget> budget )
+{
+  account_ = MemoryBudget::Account { move( budget ) };
+  account_.charge( bytes_pushed_ - bytes_popped_ );
+}
+
+void ByteStream::set_watermarks( uint64_t low,
+                                 uint64_t high,
+                                 function<void()> on_low,
+                                 function<void()> on_high )
+{
+  low_watermark_ = low;
+  high_watermark_ = high;
+  on_low_watermark_ = move( on_low );
+  on_high_watermark_ = move( on_high );
+  above_high_watermark_ = bytes_pushed_ - bytes_popped_ >= high;
+}
+
+void ByteStream::note_pushed( uint64_t len )
+{
+  bytes_pushed_ += len;
+  account_.charge( len );
+  if ( !above_high_watermark_ && bytes_pushed_ - bytes_popped_ >= high_watermark_ ) {
+    above_high_watermark_ = true;
+    if ( on_high_watermark_ )
+      on_high_watermark_();
+  }
+}
+
+void ByteStream::note_popped( uint64_t len )
+{
+  bytes_popped_ += len;
+  account_.release( len );
+  if ( above_high_watermark_ && bytes_pushed_ - bytes_popped_ <= low_watermark_ ) {
+    above_high_watermark_ = false;
+    if ( on_low_watermark_ )
+      on_low_watermark_();
+  }
+}
+
+// The free region of the ring starts right after the buffered bytes and may wrap around its end.
+uint64_t ByteStream::ring_tail()
+{
+  if ( buffer_.empty() )
+    buffer_.resize( capacity_ );
+  uint64_t tail = head_ + ( bytes_pushed_ - bytes_popped_ );
+  if ( tail >= capacity_ )
+    tail -= capacity_;
+  return tail;
+}
+
+// Pages are filled front to back; the page holding byte `head_ + bytes_buffered() + skip` is taken from the
+// pool if the stream doesn't have it yet.
+span<char> ByteStream::paged_free_run( uint64_t skip )
+{
+  const uint64_t page_size = pool_->page_size();
+  const uint64_t end = head_ + ( bytes_pushed_ - bytes_popped_ ) + skip;
+  while ( pages_.size() <= end / page_size )
+    pages_.push_back( pool_->acquire() );
+  return { pages_[end / page_size].data() + end % page_size, page_size - end % page_size };
+}
+
+// A reservation takes pages for all of its bytes; once it is committed (or abandoned), only the pages holding
+// buffered bytes are kept, so the pages in use follow the bytes buffered rather than the bytes reserved.
+void ByteStream::paged_trim()
+{
+  const uint64_t page_size = pool_->page_size();
+  const uint64_t buffered = bytes_pushed_ - bytes_popped_;
+  if ( buffered == 0 ) {
+    pages_.clear();
+    head_ = 0;
+    return;
+  }
+  const uint64_t pages_needed = ( head_ + buffered + page_size - 1 ) / page_size;
+  while ( pages_.size() > pages_needed )
+    pages_.pop_back();
+}
 
 void Writer::push( string data )
 {
-  if ( data.size() + buffer_.size() > capacity_ )
-    data.resize( capacity_ - buffer_.size() );
-  buffer_ += data;
-  bytes_pushed_ += data.size();
+  reserved_ = 0;
+  const uint64_t len = min( static_cast<uint64_t>( data.size() ), available_capacity() );
+  if ( len == 0 )
+    return;
+  if ( storage_ == Storage::Chunked ) {
+    data.resize( len );
+    chunks_.push_back( move( data ) );
+    note_pushed( len );
+    string {}.swap( staged_ ); // Drop what an abandoned reservation took
+    return;
+  }
+  if ( storage_ == Storage::Paged ) {
+    for ( uint64_t copied = 0; copied < len; ) {
+      const auto run = paged_free_run( copied );
+      const uint64_t n = min( len - copied, static_cast<uint64_t>( run.size() ) );
+      copy_n( data.data() + copied, n, run.data() );
+      copied += n;
+    }
+    note_pushed( len );
+    paged_trim(); // Drop what an abandoned reservation took
+    return;
+  }
+  const uint64_t tail = ring_tail();
+  const uint64_t first_part = min( len, capacity_ - tail );
+  copy_n( data.data(), first_part, buffer_.data() + tail );
+  copy_n( data.data() + first_part, len - first_part, buffer_.data() );
+  note_pushed( len );
+}
+
+vector<span<char>> Writer::reserve( uint64_t len )
+{
+  reserved_ = min( len, available_capacity() );
+  if ( reserved_ == 0 )
+    return {};
+  if ( storage_ == Storage::Chunked ) {
+    staged_.resize( reserved_ );
+    return { span<char> { staged_ } };
+  }
+  if ( storage_ == Storage::Paged ) {
+    vector<span<char>> spans;
+    for ( uint64_t covered = 0; covered < reserved_; ) {
+      const auto run = paged_free_run( covered );
+      spans.push_back( run.first( min( reserved_ - covered, static_cast<uint64_t>( run.size() ) ) ) );
+      covered += spans.back().size();
+    }
+    return spans;
+  }
+  const uint64_t tail = ring_tail();
+  const uint64_t first_part = min( reserved_, capacity_ - tail );
+  vector<span<char>> spans { span<char> { buffer_.data() + tail, first_part } };
+  if ( first_part < reserved_ )
+    spans.emplace_back( buffer_.data(), reserved_ - first_part );
+  return spans;
+}
+
+void Writer::commit( uint64_t len )
+{
+  if ( len > reserved_ )
+    throw runtime_error( "Writer::commit() called with more bytes than were reserved" );
+  reserved_ = 0;
+  if ( storage_ == Storage::Chunked ) {
+    // A chunk much shorter than its reservation gets a right-sized copy rather than the reservation's buffer
+    if ( len > 0 && len < staged_.size() / 2 ) {
+      chunks_.emplace_back( staged_, 0, len );
+    } else if ( len > 0 ) {
+      staged_.resize( len );
+      chunks_.push_back( move( staged_ ) );
+    }
+    string {}.swap( staged_ ); // Hand the reservation's buffer back (assigning an empty string would keep it)
+  }
+  if ( len > 0 )
+    note_pushed( len );
+  if ( storage_ == Storage::Paged )
+    paged_trim();
 }
 
 void Writer::close()
@@ -24,7 +186,7 @@ bool Writer::is_closed() const
 
 uint64_t Writer::available_capacity() const
 {
-  return capacity_ - buffer_.size();
+  return capacity_ - ( bytes_pushed_ - bytes_popped_ );
 }
 
 uint64_t Writer::bytes_pushed() const
@@ -32,25 +194,89 @@ uint64_t Writer::bytes_pushed() const
   return bytes_pushed_;
 }
 
+// Returns the longest contiguous run of buffered bytes (up to the end of the ring, front chunk or front page).
 string_view Reader::peek() const
 {
-  return buffer_;
+  if ( storage_ == Storage::Chunked )
+    return chunks_.empty() ? string_view {} : string_view { chunks_.front() }.substr( chunk_offset_ );
+  if ( storage_ == Storage::Paged )
+    return pages_.empty() ? string_view {}
+                          : string_view { pages_.front().data() + head_,
+                                          min( bytes_buffered(), pool_->page_size() - head_ ) };
+  return { buffer_.data() + head_, min( bytes_buffered(), capacity_ - head_ ) };
+}
+
+// Returns all buffered bytes (at most two pieces for the ring, else one per chunk or page), e.g. for one writev.
+vector<string_view> Reader::peek_all() const
+{
+  vector<string_view> pieces;
+  if ( storage_ == Storage::Chunked ) {
+    pieces.reserve( chunks_.size() );
+    for ( const auto& chunk : chunks_ )
+      pieces.emplace_back( chunk );
+    if ( !pieces.empty() )
+      pieces.front().remove_prefix( chunk_offset_ );
+    return pieces;
+  }
+  if ( storage_ == Storage::Paged ) {
+    const uint64_t page_size = pool_->page_size();
+    uint64_t offset = head_;
+    for ( uint64_t remaining = bytes_buffered(); remaining > 0; offset = 0 ) {
+      const uint64_t n = min( remaining, page_size - offset );
+      pieces.emplace_back( pages_[pieces.size()].data() + offset, n );
+      remaining -= n;
+    }
+    return pieces;
+  }
+  const string_view first = peek();
+  if ( !first.empty() )
+    pieces.push_back( first );
+  if ( first.size() < bytes_buffered() )
+    pieces.emplace_back( buffer_.data(), bytes_buffered() - first.size() );
+  return pieces;
 }
 
 void Reader::pop( uint64_t len )
 {
-  bytes_popped_ += len;
-  buffer_.erase( 0, len );
+  len = min( len, bytes_buffered() );
+  note_popped( len );
+  if ( storage_ == Storage::Chunked ) {
+    chunk_offset_ += len;
+    while ( !chunks_.empty() && chunk_offset_ >= chunks_.front().size() ) {
+      chunk_offset_ -= chunks_.front().size();
+      chunks_.pop_front();
+    }
+    return;
+  }
+  head_ += len;
+  if ( storage_ == Storage::Paged ) {
+    while ( head_ >= pool_->page_size() ) {
+      head_ -= pool_->page_size();
+      pages_.pop_front();
+    }
+    // A drained stream hands all of its pages back (unless a reservation is still being filled).
+    if ( bytes_buffered() == 0 && reserved_ == 0 ) {
+      pages_.clear();
+      head_ = 0;
+    }
+    return;
+  }
+  if ( head_ >= capacity_ )
+    head_ -= capacity_;
+  // Rewind an empty ring so the next pushes are peekable in one contiguous run (unless a reservation
+  // is still being filled at the old position).
+  if ( bytes_buffered() == 0 && reserved_ == 0 )
+    head_ = 0;
 }
 
 bool Reader::is_finished() const
 {
-  return closed_ && buffer_.empty();
+  return closed_ && bytes_buffered() == 0;
 }
 
 uint64_t Reader::bytes_buffered() const
 {
-  return buffer_.size();
+  return bytes_pushed_ - bytes_popped_;
 }
 
 uint64_t Reader::bytes_popped() const
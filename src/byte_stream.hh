@@ -1,16 +1,34 @@
 #pragma once
 
+#include "buffer_pool.hh"
+#include "memory_budget.hh"
+
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 class Reader;
 class Writer;
+class FileDescriptor;
 
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // How the stream keeps the bytes that have been pushed but not yet popped
+  enum class Storage : uint8_t
+  {
+    Ring,    // one circular buffer of `capacity` bytes; pop() is a pointer bump
+    Chunked, // each pushed string is kept as-is in a queue; neither push() nor pop() copies bytes
+    Paged    // pages borrowed from a shared BufferPool as bytes arrive, and returned as they are popped
+  };
+
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Ring );
+  ByteStream( uint64_t capacity, std::shared_ptr<BufferPool> pool ); // Paged storage from `pool`
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -20,12 +38,46 @@ public:
 
   void set_error() { error_ = true; };       // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
+  Storage storage() const { return storage_; }
+  uint64_t capacity() const { return capacity_; }
+
+  // Charge the bytes buffered in this stream (now and from here on) to `budget`.
+  void set_memory_budget( std::shared_ptr<MemoryBudget> budget );
+  const std::shared_ptr<MemoryBudget>& memory_budget() const { return account_.budget(); }
+
+  /*
+   * Backpressure notifications: `on_high` runs when bytes_buffered() rises to `high` or more, and
+   * `on_low` runs when it then falls back to `low` or less. Each runs once per crossing (not on every
+   * push or pop), so a consumer can stop reading when the stream fills up and resume only when a
+   * worthwhile amount of space has been freed. Copies of the stream keep the same callbacks.
+   */
+  void set_watermarks( uint64_t low, uint64_t high, std::function<void()> on_low, std::function<void()> on_high );
 
 protected:
+  uint64_t ring_tail();                            // Ring: allocate if needed; return offset of first free byte
+  std::span<char> paged_free_run( uint64_t skip ); // Paged: writable run starting `skip` bytes past the end
+  void paged_trim();                               // Paged: give back pages past the buffered bytes (all if none)
+  void note_pushed( uint64_t len );                // Count bytes added to the stream (by any storage)
+  void note_popped( uint64_t len );                // Count bytes removed from the stream (by any storage)
+
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
+  Storage storage_;
   bool error_ {};
-  std::string buffer_ {};
+  std::string buffer_ {};                 // Ring: circular buffer of `capacity_` bytes, allocated on first push
+  uint64_t head_ {};                      // Ring/Paged: offset in `buffer_` (or the front page) of the next byte
+  std::deque<std::string> chunks_ {};     // Chunked: pushed strings, oldest first
+  uint64_t chunk_offset_ {};              // Chunked: bytes of `chunks_.front()` already popped
+  std::string staged_ {};                 // Chunked: chunk handed out by Writer::reserve(), awaiting commit()
+  std::shared_ptr<BufferPool> pool_ {};   // Paged: where pages come from
+  std::deque<BufferPool::Page> pages_ {}; // Paged: pages holding the buffered bytes, oldest first
+  uint64_t reserved_ {};                  // Bytes handed out by the last Writer::reserve()
+  MemoryBudget::Account account_ {};      // Where the buffered bytes are charged
+  uint64_t low_watermark_ {};
+  uint64_t high_watermark_ { UINT64_MAX };
+  bool above_high_watermark_ {};
+  std::function<void()> on_low_watermark_ {};
+  std::function<void()> on_high_watermark_ {};
   bool closed_ {};
   uint64_t bytes_pushed_ {};
   uint64_t bytes_popped_ {};
@@ -37,6 +89,18 @@ public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
   void close();                  // Signal that the stream has reached its ending. Nothing more will be written.
 
+  /*
+   * Fill the stream in place: reserve() returns writable spans (in stream order) inside the stream's own
+   * storage, covering up to `len` bytes of available capacity. After writing into them, commit( n ) appends
+   * the first `n` of those bytes to the stream. Any other push() or reserve() discards the reservation.
+   */
+  std::vector<std::span<char>> reserve( uint64_t len );
+  void commit( uint64_t len );
+
+  // Read up to `max_len` bytes from `fd` straight into the stream with one readv, closing the stream at EOF.
+  // Returns the number of bytes read (zero if the stream is full or a non-blocking `fd` has nothing to read).
+  uint64_t read_from( FileDescriptor& fd, uint64_t max_len = UINT64_MAX );
+
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
@@ -45,8 +109,12 @@ public:
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next bytes in the buffer
-  void pop( uint64_t len );      // Remove `len` bytes from the buffer
+  std::string_view peek() const;                  // Peek at the next bytes in the buffer
+  std::vector<std::string_view> peek_all() const; // Peek at every buffered byte, as in-order contiguous pieces
+  void pop( uint64_t len );                       // Remove `len` bytes from the buffer
+
+  // Write up to `max_len` buffered bytes to `fd` with one writev, popping only what the kernel accepted.
+  uint64_t write_to( FileDescriptor& fd, uint64_t max_len = UINT64_MAX );
 
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
@@ -1,6 +1,9 @@
 #include "byte_stream.hh"
+#include "file_descriptor.hh"
 
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
 #include <stdexcept>
 
 using namespace std;
@@ -26,6 +29,46 @@ void read( Reader& reader, uint64_t max_len, string& out )
   }
 }
 
+/*
+ * read_from: reserves space in the stream, lets the kernel fill it in place,
+ * and commits however many bytes actually arrived.
+ */
+uint64_t Writer::read_from( FileDescriptor& fd, uint64_t max_len )
+{
+  const uint64_t bytes_read = fd.read( reserve( min( max_len, available_capacity() ) ) );
+  commit( bytes_read );
+  if ( fd.eof() ) {
+    close();
+  }
+  return bytes_read;
+}
+
+/*
+ * write_to: hands every buffered piece (up to `max_len` bytes) to the kernel at once,
+ * handling a partial write by popping only what was written.
+ */
+uint64_t Reader::write_to( FileDescriptor& fd, uint64_t max_len )
+{
+  if ( bytes_buffered() == 0 or max_len == 0 ) {
+    return 0;
+  }
+
+  auto pieces = peek_all();
+  uint64_t total = 0;
+  for ( auto it = pieces.begin(); it != pieces.end(); ++it ) {
+    if ( total + it->size() >= max_len ) {
+      *it = it->substr( 0, max_len - total );
+      pieces.erase( next( it ), pieces.end() );
+      break;
+    }
+    total += it->size();
+  }
+
+  const uint64_t bytes_written = fd.write( pieces );
+  pop( bytes_written );
+  return bytes_written;
+}
+
 Reader& ByteStream::reader()
 {
   static_assert( sizeof( Reader ) == sizeof( ByteStream ),
@@ -0,0 +1,126 @@
+#include "congestion_control.hh"
+#include "debug.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+unique_ptr<CongestionControl> CongestionControl::make( Algorithm algorithm, uint64_t mss )
+{
+  switch ( algorithm ) {
+    case Algorithm::None:
+      return nullptr;
+    case Algorithm::NewReno:
+      return make_unique<NewReno>( mss );
+    case Algorithm::Cubic:
+      return make_unique<Cubic>( mss );
+  }
+  return nullptr;
+}
+
+namespace {
+
+// RFC 5681's initial window: 4 segments of up to 1095 bytes, 3 up to 2190, else 2
+uint64_t initial_window( uint64_t mss )
+{
+  return min( 4 * mss, max( 2 * mss, uint64_t { 4380 } ) );
+}
+
+} // namespace
+
+NewReno::NewReno( uint64_t mss ) : mss_( mss ), cwnd_( initial_window( mss ) ) {}
+
+void NewReno::on_ack( uint64_t acked, uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += min( acked, mss_ );
+    return;
+  }
+  acked_since_growth_ += acked;
+  if ( acked_since_growth_ >= cwnd_ ) {
+    acked_since_growth_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void NewReno::on_loss( uint64_t in_flight, uint64_t /* now_ms */ )
+{
+  ssthresh_ = max( in_flight / 2, 2 * mss_ );
+  cwnd_ = ssthresh_;
+  acked_since_growth_ = 0;
+}
+
+void NewReno::on_rto( uint64_t in_flight, uint64_t /* now_ms */ )
+{
+  ssthresh_ = max( in_flight / 2, 2 * mss_ );
+  cwnd_ = mss_;
+  acked_since_growth_ = 0;
+}
+
+Cubic::Cubic( uint64_t mss )
+  : mss_( static_cast<double>( mss ) ), cwnd_( static_cast<double>( initial_window( mss ) ) )
+{}
+
+void Cubic::on_ack( uint64_t acked, uint64_t /* in_flight */, uint64_t now_ms )
+{
+  if ( cwnd() < ssthresh_ ) {
+    cwnd_ += min( static_cast<double>( acked ), mss_ );
+    return;
+  }
+
+  if ( !epoch_start_ ) {
+    // The first ACK in congestion avoidance starts the clock. Below the last W_max, W(t) climbs back up
+    // to it; otherwise (e.g. after a timeout with no loss before it), it starts probing right away.
+    epoch_start_ = now_ms;
+    if ( cwnd_ < w_max_ ) {
+      k_ = cbrt( ( w_max_ - cwnd_ ) / mss_ / C );
+      origin_ = w_max_;
+    } else {
+      k_ = 0;
+      origin_ = cwnd_;
+    }
+    w_est_ = cwnd_;
+  }
+
+  // Aim for where W(t) will be one RTT from now, growing by at most half the window per RTT
+  const uint64_t rtt_ms = min_rtt_ms_ == UINT64_MAX ? 0 : min_rtt_ms_;
+  const double t = static_cast<double>( now_ms - *epoch_start_ + rtt_ms ) / 1000.0;
+  const double w_cubic = origin_ + C * ( t - k_ ) * ( t - k_ ) * ( t - k_ ) * mss_;
+  double target = min( w_cubic, 1.5 * cwnd_ );
+
+  // Standard TCP's window with the same decrease factor: 3(1-β)/(1+β) segments more per window acked
+  w_est_ += 3.0 * ( 1 - BETA ) / ( 1 + BETA ) * mss_ * static_cast<double>( acked ) / cwnd_;
+  target = max( target, w_est_ );
+
+  if ( target > cwnd_ ) {
+    cwnd_ += ( target - cwnd_ ) * static_cast<double>( acked ) / cwnd_;
+  } else {
+    cwnd_ += mss_ * static_cast<double>( acked ) / ( 100 * cwnd_ ); // On the plateau: creep up
+  }
+}
+
+void Cubic::reduce()
+{
+  // Fast convergence: losing before reaching the last W_max means another flow is taking its share
+  w_max_ = cwnd_ < w_max_ ? cwnd_ * ( 1 + BETA ) / 2 : cwnd_;
+  ssthresh_ = max( static_cast<uint64_t>( cwnd_ * BETA ), static_cast<uint64_t>( 2 * mss_ ) );
+  epoch_start_.reset();
+}
+
+void Cubic::on_loss( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+  reduce();
+  cwnd_ = static_cast<double>( ssthresh_ );
+}
+
+void Cubic::on_rto( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+  reduce();
+  cwnd_ = mss_;
+}
+
+void Cubic::on_rtt_sample( uint64_t rtt_ms )
+{
+  min_rtt_ms_ = min( min_rtt_ms_, rtt_ms );
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+/*
+ * CongestionControl: how much a TCPSender may have in flight, as the path (not the receiver) allows.
+ *
+ * The sender reports each acknowledgment of new data, each loss it detects, and each expiry of its
+ * retransmission timer; the algorithm answers with a congestion window (cwnd), in sequence numbers.
+ * The sender never has more in flight than the smaller of cwnd and the receiver's window. Times are
+ * the sender's own clock: the milliseconds passed to TCPSender::tick() so far.
+ */
+class CongestionControl
+{
+public:
+  enum class Algorithm : uint8_t
+  {
+    None,    // no congestion window: send whatever the receiver's window allows
+    NewReno, // slow start, congestion avoidance and multiplicative decrease (RFC 5681)
+    Cubic    // window growth as a cubic function of the time since the last loss (RFC 8312)
+  };
+
+  // The algorithm's state for a sender whose segments carry at most `mss` bytes (nullptr for None)
+  static std::unique_ptr<CongestionControl> make( Algorithm algorithm, uint64_t mss );
+
+  CongestionControl() = default;
+  CongestionControl( const CongestionControl& other ) = default;
+  CongestionControl& operator=( const CongestionControl& other ) = default;
+  CongestionControl( CongestionControl&& other ) noexcept = default;
+  CongestionControl& operator=( CongestionControl&& other ) noexcept = default;
+  virtual ~CongestionControl() = default;
+
+  virtual void on_ack( uint64_t acked, uint64_t in_flight, uint64_t now_ms ) = 0; // `acked` new seqnos acked
+  virtual void on_loss( uint64_t in_flight, uint64_t now_ms ) = 0; // a loss was found without a timeout
+  virtual void on_rto( uint64_t in_flight, uint64_t now_ms ) = 0;  // the retransmission timer expired
+  virtual void on_rtt_sample( uint64_t /* rtt_ms */ ) {}           // a timed segment took `rtt_ms` to be acked
+
+  virtual uint64_t cwnd() const = 0;
+  virtual uint64_t ssthresh() const = 0;
+};
+
+/*
+ * NewReno window management (RFC 5681, with appropriate byte counting from RFC 3465): the window
+ * starts at the RFC 5681 initial window and, below ssthresh, grows by up to one MSS per ACK (slow
+ * start); above it, by one MSS per window of data acknowledged (congestion avoidance). A loss halves
+ * what was in flight to set ssthresh, and the window falls to it; a timeout also falls to one MSS.
+ */
+class NewReno : public CongestionControl
+{
+public:
+  explicit NewReno( uint64_t mss );
+
+  void on_ack( uint64_t acked, uint64_t in_flight, uint64_t now_ms ) override;
+  void on_loss( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_rto( uint64_t in_flight, uint64_t now_ms ) override;
+
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t ssthresh() const override { return ssthresh_; }
+
+private:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ = UINT64_MAX;
+  uint64_t acked_since_growth_ = 0; // Congestion avoidance: bytes acked since cwnd last grew
+};
+
+/*
+ * CUBIC window management (RFC 8312). After a loss the window is cut to 0.7 of what it was, then
+ * follows W(t) = C (t - K)^3 + W_max, where t is the time since the cut and K the time W takes to get
+ * back to W_max, the window at the loss: quickly at first, flattening out near W_max, then probing
+ * beyond it ever faster. Growth depends on time rather than on the number of round trips, so a path
+ * with a large bandwidth-delay product fills in seconds, whatever its RTT. Where standard TCP would
+ * grow faster (short RTTs), the window follows an estimate of standard TCP's instead (the TCP-friendly
+ * region). With fast convergence, a loss below the previous W_max lowers W_max further, to leave room
+ * for new flows. Slow start and timeouts are handled as by NewReno, with ssthresh set by the 0.7 cut.
+ */
+class Cubic : public CongestionControl
+{
+public:
+  explicit Cubic( uint64_t mss );
+
+  void on_ack( uint64_t acked, uint64_t in_flight, uint64_t now_ms ) override;
+  void on_loss( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_rto( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_rtt_sample( uint64_t rtt_ms ) override;
+
+  uint64_t cwnd() const override { return static_cast<uint64_t>( cwnd_ ); }
+  uint64_t ssthresh() const override { return ssthresh_; }
+  uint64_t w_max() const { return static_cast<uint64_t>( w_max_ ); }
+
+  static constexpr double C = 0.4;    // Scales the cubic function (in segments per second cubed)
+  static constexpr double BETA = 0.7; // Multiplicative decrease factor
+
+private:
+  void reduce(); // Remember W_max and cut ssthresh on a loss or timeout
+
+  double mss_;
+  double cwnd_; // In bytes, with the fractions of a byte that per-ACK growth adds up to
+  uint64_t ssthresh_ = UINT64_MAX;
+  double w_max_ = 0;                       // Window at the last loss, in bytes (after fast convergence)
+  std::optional<uint64_t> epoch_start_ {}; // When congestion avoidance last began (unset after a loss)
+  double k_ = 0;                           // Seconds from the epoch's start until W(t) reaches its plateau
+  double origin_ = 0;                      // The plateau of W(t) for this epoch, in bytes
+  double w_est_ = 0;                       // Estimate of standard TCP's window, in bytes
+  uint64_t min_rtt_ms_ = UINT64_MAX;
+};
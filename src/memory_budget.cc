@@ -0,0 +1,60 @@
+#include "memory_budget.hh"
+
+#include <utility>
+
+using namespace std;
+
+void MemoryBudget::add( uint64_t bytes )
+{
+  const uint64_t now = current_.fetch_add( bytes, memory_order_relaxed ) + bytes;
+  uint64_t peak = peak_.load( memory_order_relaxed );
+  while ( now > peak && !peak_.compare_exchange_weak( peak, now, memory_order_relaxed ) ) {}
+}
+
+MemoryBudget::Account::Account( shared_ptr<MemoryBudget> budget ) : budget_( move( budget ) )
+{
+  if ( budget_ ) {
+    budget_->accounts_.fetch_add( 1, memory_order_relaxed );
+  }
+}
+
+MemoryBudget::Account::Account( const Account& other ) : Account( other.budget_ )
+{
+  charge( other.charged_ );
+}
+
+MemoryBudget::Account& MemoryBudget::Account::operator=( const Account& other )
+{
+  if ( this != &other ) {
+    *this = Account { other };
+  }
+  return *this;
+}
+
+MemoryBudget::Account::Account( Account&& other ) noexcept
+  : budget_( move( other.budget_ ) ), charged_( exchange( other.charged_, 0 ) )
+{}
+
+MemoryBudget::Account& MemoryBudget::Account::operator=( Account&& other ) noexcept
+{
+  if ( this != &other ) {
+    close();
+    budget_ = move( other.budget_ );
+    charged_ = exchange( other.charged_, 0 );
+  }
+  return *this;
+}
+
+MemoryBudget::Account::~Account()
+{
+  close();
+}
+
+void MemoryBudget::Account::close()
+{
+  if ( budget_ ) {
+    release( charged_ );
+    budget_->accounts_.fetch_sub( 1, memory_order_relaxed );
+    budget_.reset();
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/*
+ * MemoryBudget: accounts for the bytes held by many ByteStreams and Reassemblers at once.
+ *
+ * Each stream or reassembler charges its buffered bytes to an Account opened on a shared budget.
+ * The budget tracks the current and peak totals across all of its accounts. A TCPReceiver whose
+ * Reassembler is charged to a budget never advertises a window larger than what is left of the
+ * budget, so a process with many connections slows its peers down rather than growing without bound.
+ *
+ * A budget may be shared by accounts on different threads.
+ */
+class MemoryBudget
+{
+public:
+  explicit MemoryBudget( uint64_t limit = UINT64_MAX ) : limit_( limit ) {}
+
+  // The bytes charged by one stream or reassembler. Copying an Account charges the same bytes again.
+  class Account
+  {
+  public:
+    Account() = default;
+    explicit Account( std::shared_ptr<MemoryBudget> budget );
+    Account( const Account& other );
+    Account& operator=( const Account& other );
+    Account( Account&& other ) noexcept;
+    Account& operator=( Account&& other ) noexcept;
+    ~Account();
+
+    void charge( uint64_t bytes )
+    {
+      charged_ += bytes;
+      if ( budget_ ) {
+        budget_->add( bytes );
+      }
+    }
+
+    void release( uint64_t bytes )
+    {
+      charged_ -= bytes;
+      if ( budget_ ) {
+        budget_->remove( bytes );
+      }
+    }
+
+    uint64_t charged() const { return charged_; }
+    const std::shared_ptr<MemoryBudget>& budget() const { return budget_; }
+
+  private:
+    void close(); // Release everything charged and detach from the budget
+
+    std::shared_ptr<MemoryBudget> budget_ {};
+    uint64_t charged_ {};
+  };
+
+  uint64_t limit() const { return limit_; }
+  uint64_t current() const { return current_.load( std::memory_order_relaxed ); } // Bytes charged right now
+  uint64_t peak() const { return peak_.load( std::memory_order_relaxed ); }       // Most bytes ever charged at once
+  uint64_t accounts() const { return accounts_.load( std::memory_order_relaxed ); } // Open accounts
+
+  // How many more bytes fit under the limit?
+  uint64_t available() const
+  {
+    const uint64_t used = current();
+    return used >= limit_ ? 0 : limit_ - used;
+  }
+
+  // Accounts keep the budget alive and give their charges back to it when closed; a copy would see none of them
+  MemoryBudget( const MemoryBudget& other ) = delete;
+  MemoryBudget& operator=( const MemoryBudget& other ) = delete;
+  MemoryBudget( MemoryBudget&& other ) = delete;
+  MemoryBudget& operator=( MemoryBudget&& other ) = delete;
+  ~MemoryBudget() = default;
+
+private:
+  void add( uint64_t bytes );
+  void remove( uint64_t bytes ) { current_.fetch_sub( bytes, std::memory_order_relaxed ); }
+
+  uint64_t limit_;
+  std::atomic<uint64_t> current_ {};
+  std::atomic<uint64_t> peak_ {};
+  std::atomic<uint64_t> accounts_ {};
+};
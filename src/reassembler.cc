@@ -1,67 +1,685 @@
 #include "reassembler.hh"
 #include "debug.hh"
 
+#include <algorithm>
+#include <bit>
+
 using namespace std;
 
+namespace {
+
+// Set bits [pos, pos + len) of `bits`; return how many of them were clear
+uint64_t set_bits( vector<uint64_t>& bits, uint64_t pos, uint64_t len )
+{
+  uint64_t changed = 0;
+  while ( len > 0 ) {
+    const uint64_t offset = pos % 64;
+    const uint64_t n = min( len, 64 - offset );
+    const uint64_t mask = ( n == 64 ? ~uint64_t {} : ( uint64_t { 1 } << n ) - 1 ) << offset;
+    changed += popcount( mask & ~bits[pos / 64] );
+    bits[pos / 64] |= mask;
+    pos += n;
+    len -= n;
+  }
+  return changed;
+}
+
+// Clear bits [pos, pos + len) of `bits`; return how many of them were set
+uint64_t clear_bits( vector<uint64_t>& bits, uint64_t pos, uint64_t len )
+{
+  uint64_t changed = 0;
+  while ( len > 0 ) {
+    const uint64_t offset = pos % 64;
+    const uint64_t n = min( len, 64 - offset );
+    const uint64_t mask = ( n == 64 ? ~uint64_t {} : ( uint64_t { 1 } << n ) - 1 ) << offset;
+    changed += popcount( mask & bits[pos / 64] );
+    bits[pos / 64] &= ~mask;
+    pos += n;
+    len -= n;
+  }
+  return changed;
+}
+
+// How many bits of `bits` in [pos, end) are set with the bit before them clear (bit `pos - 1` if pos > 0)?
+uint64_t count_run_starts( const vector<uint64_t>& bits, uint64_t pos, uint64_t end )
+{
+  uint64_t starts = 0;
+  while ( pos < end ) {
+    const uint64_t offset = pos % 64;
+    const uint64_t n = min( end - pos, 64 - offset );
+    const uint64_t mask = ( n == 64 ? ~uint64_t {} : ( uint64_t { 1 } << n ) - 1 ) << offset;
+    const uint64_t word = bits[pos / 64];
+    const uint64_t before = word << 1 | ( pos >= 64 ? bits[pos / 64 - 1] >> 63 : 0 );
+    starts += popcount( word & ~before & mask );
+    pos += n;
+  }
+  return starts;
+}
+
+// How many bits of `bits` are set (or clear) in a row, starting at `pos` and stopping at `end`?
+uint64_t count_run( const vector<uint64_t>& bits, uint64_t pos, uint64_t end, bool set )
+{
+  const uint64_t start = pos;
+  while ( pos < end ) {
+    const uint64_t offset = pos % 64;
+    const uint64_t word = set ? bits[pos / 64] : ~bits[pos / 64];
+    const auto ones = static_cast<uint64_t>( countr_one( word >> offset ) );
+    pos += ones;
+    if ( ones < 64 - offset )
+      break;
+  }
+  return min( pos, end ) - start;
+}
+
+// How many bits of `bits` just below `end` (down to `begin`) are set (or clear) in a row?
+uint64_t count_run_before( const vector<uint64_t>& bits, uint64_t end, uint64_t begin, bool set )
+{
+  const uint64_t start = end;
+  while ( end > begin ) {
+    const uint64_t top = ( end - 1 ) % 64;
+    const uint64_t word = set ? bits[( end - 1 ) / 64] : ~bits[( end - 1 ) / 64];
+    const auto ones = static_cast<uint64_t>( countl_one( word << ( 63 - top ) ) );
+    end -= ones;
+    if ( ones < top + 1 )
+      break;
+  }
+  return start - max( end, begin );
+}
+
+} // namespace
+
+string_view Reassembler::storage_name( Storage storage )
+{
+  switch ( storage ) {
+    case Storage::Map:
+      return "map";
+    case Storage::Ring:
+      return "ring";
+    case Storage::Flat:
+      return "flat";
+    case Storage::Slices:
+      return "slices";
+  }
+  return "unknown";
+}
+
 void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring )
+{
+  if ( storage_ == Storage::Slices ) {
+    insert( first_index, make_shared<const string>( move( data ) ), is_last_substring );
+    return;
+  }
+  const auto admitted = admit( first_index, data.size(), is_last_substring );
+  if ( !admitted )
+    return;
+  const auto [skip, len] = *admitted;
+  if ( skip > 0 ) {
+    data = data.substr( skip );
+    first_index += skip;
+  }
+  data.resize( len );
+  const uint64_t known = next_index_ + pending_account_.charged();
+  // Nothing to store for an empty substring (and an empty entry in `pending_` would shadow later data)
+  if ( !data.empty() ) {
+    switch ( storage_ ) {
+      case Storage::Map:
+        insert_map( first_index, move( data ) );
+        break;
+      case Storage::Ring:
+        insert_ring( first_index, move( data ) );
+        break;
+      case Storage::Flat:
+        insert_flat( first_index, move( data ) );
+        break;
+      case Storage::Slices:
+        break;
+    }
+  }
+  settle( known, len );
+}
+
+void Reassembler::insert( uint64_t first_index, shared_ptr<const string> data, bool is_last_substring )
+{
+  if ( storage_ != Storage::Slices ) {
+    insert( first_index, string { *data }, is_last_substring );
+    return;
+  }
+  const auto admitted = admit( first_index, data->size(), is_last_substring );
+  if ( !admitted )
+    return;
+  const auto [skip, len] = *admitted;
+  const uint64_t known = next_index_ + pending_account_.charged();
+  if ( len > 0 )
+    insert_slices( first_index + skip, data, string_view { *data }.substr( skip, len ) );
+  settle( known, len );
+}
+
+optional<pair<uint64_t, uint64_t>> Reassembler::admit( uint64_t first_index, uint64_t len, bool is_last_substring )
 {
   if ( is_last_substring )
-    last_index_ = first_index + data.size();
+    last_index_ = first_index + len;
+  if ( first_index > next_index_ )
+    stats_.max_out_of_order_distance = max( stats_.max_out_of_order_distance, first_index - next_index_ );
+  uint64_t skip = 0;
   if ( first_index < next_index_ ) {
-    if ( first_index + data.size() <= next_index_ )
-      return;
-    data = data.substr( next_index_ - first_index );
+    if ( first_index + len <= next_index_ ) {
+      stats_.duplicate_bytes += len;
+      return nullopt;
+    }
+    skip = next_index_ - first_index;
+    stats_.duplicate_bytes += skip;
     first_index = next_index_;
+    len -= skip;
   }
-  if ( output_.writer().available_capacity() + next_index_ < data.size()
-       || output_.writer().available_capacity() + next_index_ - data.size() < first_index ) {
-    if ( output_.writer().available_capacity() + next_index_ <= first_index )
-      return;
-    data.resize( output_.writer().available_capacity() - first_index + next_index_ );
+  if ( output_.writer().available_capacity() + next_index_ < len
+       || output_.writer().available_capacity() + next_index_ - len < first_index ) {
+    if ( output_.writer().available_capacity() + next_index_ <= first_index ) {
+      stats_.bytes_discarded += len;
+      return nullopt;
+    }
+    const uint64_t kept = output_.writer().available_capacity() - first_index + next_index_;
+    stats_.bytes_discarded += len - kept;
+    len = kept;
   }
+  return pair { skip, len };
+}
+
+void Reassembler::settle( uint64_t known, uint64_t len )
+{
+  // Whatever the admitted bytes didn't add to the bytes written or stored, we had already
+  stats_.duplicate_bytes += len - ( next_index_ + pending_account_.charged() - known );
+  prune();
+  if ( next_index_ == last_index_ )
+    output_.writer().close();
+}
+
+void Reassembler::insert_many( span<Substring> substrings )
+{
+  for ( const auto& substring : substrings )
+    if ( substring.is_last_substring )
+      last_index_ = substring.first_index + substring.data.size();
+
+  // Merge the batch into runs, counting what insert() would have for each substring merged away
+  struct Run
+  {
+    uint64_t first_index;
+    string data;
+    uint64_t last_first_index; // Where the last substring merged into the run started
+    uint64_t merges;           // Stored bytes the substrings merged into the run would have joined onto
+  };
+  const uint64_t capacity_end = next_index_ + output_.writer().available_capacity(); // (nothing is read meanwhile)
+  ranges::sort( substrings, {}, &Substring::first_index );
+  vector<Run> runs;
+  for ( auto& substring : substrings ) {
+    const uint64_t first_index = substring.first_index;
+    const uint64_t end = first_index + substring.data.size();
+    if ( runs.empty() || first_index > runs.back().first_index + runs.back().data.size() ) {
+      runs.push_back( { first_index, move( substring.data ), first_index, 0 } );
+      continue;
+    }
+    auto& run = runs.back();
+    const uint64_t run_end = run.first_index + run.data.size();
+    // The bytes shared with the run are duplicates, or discarded if they are beyond the stream's capacity
+    const uint64_t overlap_end = min( end, run_end );
+    const uint64_t duplicate = clamp( capacity_end, first_index, overlap_end ) - first_index;
+    stats_.duplicate_bytes += duplicate;
+    stats_.bytes_discarded += overlap_end - first_index - duplicate;
+    if ( end > first_index && first_index < capacity_end && run_end > run.first_index )
+      run.merges++;
+    run.last_first_index = first_index;
+    if ( end > run_end )
+      run.data.append( substring.data, run_end - first_index );
+  }
+
+  // Each run that reaches the stream is written, along with whatever stored bytes it makes contiguous
+  for ( auto& run : runs ) {
+    // (Substrings that arrive in order are written, not stored, so they join nothing)
+    if ( run.first_index > next_index_ )
+      stats_.merges += run.merges;
+    insert( run.first_index, move( run.data ), false );
+    if ( run.last_first_index > next_index_ )
+      stats_.max_out_of_order_distance
+        = max( stats_.max_out_of_order_distance, run.last_first_index - next_index_ );
+  }
+  // (A run that was all duplicate is never settled, but may have carried the last substring)
+  if ( next_index_ == last_index_ )
+    output_.writer().close();
+}
+
+void Reassembler::insert_in_order( string data )
+{
+  next_index_ += data.size();
+  output_.writer().push( move( data ) );
+  if ( next_index_ == last_index_ )
+    output_.writer().close();
+}
+
+void Reassembler::insert_map( uint64_t first_index, string data )
+{
   auto it = pending_.upper_bound( first_index );
   if ( it != pending_.begin() ) {
     --it;
-    if ( it->first + it->second.size() > first_index ) {
-      // Overlapping with previous
+    if ( it->first + it->second.size() >= first_index ) {
+      // Overlapping with (or touching) previous
+      stats_.merges++;
       const uint64_t overlap = it->first + it->second.size() - first_index;
       if ( overlap >= data.size() )
         // Fully covered by previous
         return;
       it->second.append( data.substr( overlap ) );
-    } else
+      pending_account_.charge( data.size() - overlap );
+    } else {
+      pending_account_.charge( data.size() );
       it = pending_.insert( { first_index, move( data ) } ).first;
-  } else
+    }
+  } else {
+    pending_account_.charge( data.size() );
     it = pending_.insert( { first_index, move( data ) } ).first;
+  }
   // Now we have the new data in 'it'
   // Check if we can merge with next
   // assert( it != pending_.end() );
   auto next_it = next( it );
   while ( next_it != pending_.end() && it->first + it->second.size() >= next_it->first ) {
     // Overlapping with next
+    stats_.merges++;
     const uint64_t overlap = it->first + it->second.size() - next_it->first;
     if ( overlap < next_it->second.size() )
       it->second.append( next_it->second.substr( overlap ) );
+    pending_account_.release( min( overlap, static_cast<uint64_t>( next_it->second.size() ) ) );
     pending_.erase( next_it );
     next_it = next( it );
   }
   // Now we have the new data in 'it' and it doesn't overlap with next
   // Check if we can write to output
   if ( it->first == next_index_ ) {
-    output_.writer().push( it->second );
+    pending_account_.release( it->second.size() );
     next_index_ += it->second.size();
+    output_.writer().push( move( it->second ) );
     pending_.erase( it );
   }
-  if ( next_index_ == last_index_ )
-    output_.writer().close();
+}
+
+void Reassembler::insert_ring( uint64_t first_index, string data )
+{
+  const uint64_t capacity = output_.capacity();
+  if ( first_index == next_index_ ) {
+    // In order: hand the string straight to the stream, and forget any copies of these bytes stored earlier.
+    // Every stored run these bytes overlap or touch is joined to them; only one continuing past them is left.
+    const uint64_t end = first_index + data.size();
+    const uint64_t joined = runs_overlapping( first_index, min( end + 1, next_index_ + capacity ) - first_index );
+    ring_runs_ -= joined - is_present( end );
+    stats_.merges += joined;
+    pending_account_.release( mark_absent( first_index, data.size() ) );
+    next_index_ += data.size();
+    output_.writer().push( move( data ) );
+  } else {
+    if ( present_.empty() )
+      present_.assign( ( output_.capacity() + 63 ) / 64, 0 );
+    stash( first_index, data );
+    // The new bytes join every stored run they overlap or touch into one
+    const uint64_t lo = first_index - 1;
+    const uint64_t hi = min( first_index + data.size() + 1, next_index_ + capacity );
+    const uint64_t joined = runs_overlapping( lo, hi - lo );
+    pending_account_.charge( mark_present( first_index, data.size() ) );
+    ring_runs_ = ring_runs_ + 1 - joined;
+    stats_.merges += joined;
+  }
+
+  // Write out whatever is now contiguous with the stream
+  const uint64_t run = present_run( next_index_ );
+  if ( run > 0 ) {
+    ring_runs_--;
+    pending_account_.release( mark_absent( next_index_, run ) );
+    write_from_window( run );
+  }
+}
+
+void Reassembler::insert_flat( uint64_t first_index, string data )
+{
+  if ( first_index == next_index_ ) {
+    // In order: hand the string straight to the stream, and forget any stored ranges (or parts) it covers
+    const uint64_t end = first_index + data.size();
+    const auto head = ranges_.begin() + static_cast<ptrdiff_t>( ranges_head_ );
+    const auto covered = partition_point( head, ranges_.end(), [&]( const auto& r ) { return r.second <= end; } );
+    stats_.merges += partition_point( covered, ranges_.end(), [&]( const auto& r ) { return r.first <= end; } )
+                     - head;
+    uint64_t released = 0;
+    for ( auto it = head; it != covered; ++it )
+      released += it->second - it->first;
+    drop_front_ranges( covered - head );
+    if ( ranges_head_ < ranges_.size() && ranges_[ranges_head_].first < end ) {
+      released += end - ranges_[ranges_head_].first;
+      ranges_[ranges_head_].first = end;
+    }
+    pending_account_.release( released );
+    next_index_ = end;
+    output_.writer().push( move( data ) );
+  } else {
+    stash( first_index, data );
+    pending_account_.charge( add_range( first_index, first_index + data.size() ) );
+  }
+
+  // Write out the first range if it is now contiguous with the stream
+  if ( ranges_head_ < ranges_.size() && ranges_[ranges_head_].first == next_index_ ) {
+    const uint64_t len = ranges_[ranges_head_].second - ranges_[ranges_head_].first;
+    drop_front_ranges( 1 );
+    pending_account_.release( len );
+    write_from_window( len );
+  }
+}
+
+void Reassembler::insert_slices( uint64_t first_index, const shared_ptr<const string>& buffer, string_view data )
+{
+  // The new bytes join every stored run they overlap or touch into one
+  const uint64_t end = first_index + data.size();
+  auto it = slices_.lower_bound( first_index );
+  if ( it != slices_.begin() && prev( it )->first + prev( it )->second.bytes.size() >= first_index )
+    --it;
+  uint64_t joined = 0;
+  for ( auto run = it; run != slices_.end() && run->first <= end; ++run )
+    if ( run == it || prev( run )->first + prev( run )->second.bytes.size() < run->first )
+      joined++;
+  slice_runs_ = slice_runs_ + 1 - joined;
+  stats_.merges += joined;
+
+  // Keep a reference to each part of `data` that falls in a hole, without copying it
+  for ( uint64_t index = first_index; index < end; ) {
+    while ( it != slices_.end() && it->first + it->second.bytes.size() <= index )
+      ++it;
+    const uint64_t hole_end = it == slices_.end() ? end : min( end, it->first );
+    if ( hole_end > index ) {
+      slices_.emplace_hint( it, index, Slice { buffer, data.substr( index - first_index, hole_end - index ) } );
+      pending_account_.charge( hole_end - index );
+      index = hole_end;
+    } else {
+      index = it->first + it->second.bytes.size();
+    }
+  }
+
+  // Copy the slices now contiguous with the stream straight into its own storage
+  uint64_t len = 0;
+  auto last = slices_.begin();
+  for ( ; last != slices_.end() && last->first == next_index_ + len; ++last )
+    len += last->second.bytes.size();
+  if ( len == 0 )
+    return;
+  slice_runs_--;
+  auto slice = slices_.begin();
+  uint64_t offset = 0;
+  for ( const auto span : output_.writer().reserve( len ) ) {
+    for ( uint64_t filled = 0; filled < span.size(); ) {
+      const uint64_t n = min( static_cast<uint64_t>( span.size() ) - filled, slice->second.bytes.size() - offset );
+      copy_n( slice->second.bytes.data() + offset, n, span.data() + filled );
+      filled += n;
+      offset += n;
+      if ( offset == slice->second.bytes.size() ) {
+        ++slice;
+        offset = 0;
+      }
+    }
+  }
+  output_.writer().commit( len );
+  slices_.erase( slices_.begin(), last );
+  pending_account_.release( len );
+  next_index_ += len;
+}
+
+void Reassembler::stash( uint64_t first_index, string_view data )
+{
+  const uint64_t capacity = output_.capacity();
+  if ( window_.empty() )
+    window_.resize( capacity );
+  const uint64_t pos = first_index % capacity;
+  const uint64_t first_part = min( static_cast<uint64_t>( data.size() ), capacity - pos );
+  copy_n( data.data(), first_part, window_.data() + pos );
+  copy_n( data.data() + first_part, data.size() - first_part, window_.data() );
+}
+
+void Reassembler::write_from_window( uint64_t len )
+{
+  // Copy from the window straight into the stream's own storage
+  const uint64_t capacity = window_.size();
+  uint64_t copied = 0;
+  for ( const auto span : output_.writer().reserve( len ) ) {
+    for ( uint64_t filled = 0; filled < span.size(); ) {
+      const uint64_t pos = ( next_index_ + copied ) % capacity;
+      const uint64_t n = min( static_cast<uint64_t>( span.size() ) - filled, capacity - pos );
+      copy_n( window_.data() + pos, n, span.data() + filled );
+      filled += n;
+      copied += n;
+    }
+  }
+  output_.writer().commit( copied );
+  next_index_ += copied;
+}
+
+uint64_t Reassembler::add_range( uint64_t start, uint64_t end )
+{
+  // Merge [start, end) with every stored range it overlaps or touches
+  auto first = partition_point( ranges_.begin() + static_cast<ptrdiff_t>( ranges_head_ ),
+                                ranges_.end(),
+                                [&]( const auto& r ) { return r.second < start; } );
+  auto last = partition_point( first, ranges_.end(), [&]( const auto& r ) { return r.first <= end; } );
+  if ( first == last ) {
+    ranges_.insert( first, { start, end } );
+    return end - start;
+  }
+  stats_.merges += last - first;
+  uint64_t already_stored = 0;
+  for ( auto it = first; it != last; ++it )
+    already_stored += it->second - it->first;
+  *first = { min( start, first->first ), max( end, prev( last )->second ) };
+  ranges_.erase( next( first ), last );
+  return first->second - first->first - already_stored;
+}
+
+void Reassembler::drop_front_ranges( uint64_t count )
+{
+  // Skip past them, and only shift the vector down once they make up half of it: amortized O(1) per range
+  ranges_head_ += count;
+  if ( ranges_head_ * 2 >= ranges_.size() ) {
+    ranges_.erase( ranges_.begin(), ranges_.begin() + static_cast<ptrdiff_t>( ranges_head_ ) );
+    ranges_head_ = 0;
+  }
+}
+
+uint64_t Reassembler::mark_present( uint64_t index, uint64_t len )
+{
+  const uint64_t capacity = window_.size();
+  const uint64_t pos = index % capacity;
+  const uint64_t first_part = min( len, capacity - pos );
+  return set_bits( present_, pos, first_part ) + set_bits( present_, 0, len - first_part );
+}
+
+uint64_t Reassembler::mark_absent( uint64_t index, uint64_t len )
+{
+  const uint64_t capacity = window_.size();
+  if ( capacity == 0 )
+    return 0;
+  const uint64_t pos = index % capacity;
+  const uint64_t first_part = min( len, capacity - pos );
+  return clear_bits( present_, pos, first_part ) + clear_bits( present_, 0, len - first_part );
+}
+
+uint64_t Reassembler::present_run( uint64_t index, bool present ) const
+{
+  const uint64_t capacity = window_.size();
+  if ( capacity == 0 )
+    return 0;
+  const uint64_t pos = index % capacity;
+  const uint64_t run = count_run( present_, pos, capacity, present );
+  return run < capacity - pos ? run : run + count_run( present_, 0, pos, present );
+}
+
+size_t Reassembler::received_blocks( span<Block> blocks ) const
+{
+  size_t filled = 0;
+  switch ( storage_ ) {
+    case Storage::Map:
+      for ( auto it = pending_.begin(); it != pending_.end() && filled < blocks.size(); ++it )
+        blocks[filled++] = { it->first, it->first + it->second.size() };
+      break;
+    case Storage::Ring: {
+      // Alternate between runs of absent and present bytes, across the window
+      const uint64_t end = next_index_ + window_.size();
+      for ( uint64_t index = next_index_; filled < blocks.size() && index < end; ) {
+        index += present_run( index, false );
+        if ( index >= end )
+          break;
+        const uint64_t len = present_run( index );
+        blocks[filled++] = { index, index + len };
+        index += len;
+      }
+      break;
+    }
+    case Storage::Flat:
+      for ( ; ranges_head_ + filled < ranges_.size() && filled < blocks.size(); ++filled )
+        blocks[filled] = { ranges_[ranges_head_ + filled].first, ranges_[ranges_head_ + filled].second };
+      break;
+    case Storage::Slices:
+      // Touching slices are reported as one block
+      for ( const auto& [index, slice] : slices_ ) {
+        if ( filled > 0 && blocks[filled - 1].end == index ) {
+          blocks[filled - 1].end += slice.bytes.size();
+        } else if ( filled < blocks.size() ) {
+          blocks[filled++] = { index, index + slice.bytes.size() };
+        } else {
+          break;
+        }
+      }
+      break;
+  }
+  return filled;
+}
+
+uint64_t Reassembler::runs_overlapping( uint64_t index, uint64_t len ) const
+{
+  const uint64_t capacity = window_.size();
+  if ( capacity == 0 || len == 0 )
+    return 0;
+  const uint64_t pos = index % capacity;
+  const uint64_t first_part = min( len, capacity - pos );
+  // The run holding the first byte (if any), plus every run that starts after it
+  uint64_t runs = is_present( index ) + count_run_starts( present_, pos + 1, pos + first_part );
+  if ( len > first_part ) {
+    runs += count_run_starts( present_, 0, len - first_part );
+    if ( is_present( index + first_part ) && is_present( index + first_part - 1 ) )
+      runs--; // the run at the start of the window continues the one at its end
+  }
+  return runs;
+}
+
+bool Reassembler::is_present( uint64_t index ) const
+{
+  const uint64_t capacity = window_.size();
+  return capacity > 0 && ( present_[index % capacity / 64] >> ( index % capacity % 64 ) & 1 );
+}
+
+uint64_t Reassembler::present_run_before( uint64_t end, bool present ) const
+{
+  const uint64_t capacity = window_.size();
+  if ( capacity == 0 )
+    return 0;
+  const uint64_t pos = end % capacity;
+  const uint64_t run = count_run_before( present_, pos, 0, present );
+  return run < pos ? run : run + count_run_before( present_, capacity, pos, present );
+}
+
+uint64_t Reassembler::stored_runs() const
+{
+  switch ( storage_ ) {
+    case Storage::Map:
+      return pending_.size();
+    case Storage::Ring:
+      return ring_runs_;
+    case Storage::Flat:
+      return ranges_.size() - ranges_head_;
+    case Storage::Slices:
+      return slice_runs_;
+  }
+  return 0;
+}
+
+Reassembler::Stats Reassembler::stats() const
+{
+  Stats stats = stats_;
+  stats.holes = stored_runs();
+  return stats;
+}
+
+void Reassembler::set_pending_limits( uint64_t max_bytes, uint64_t max_runs )
+{
+  max_pending_bytes_ = max_bytes;
+  max_pending_runs_ = max_runs;
+  prune();
+}
+
+void Reassembler::prune()
+{
+  uint64_t pruned = 0;
+  while ( stored_runs() > max_pending_runs_ )
+    pruned += drop_farthest( UINT64_MAX );
+  while ( pending_account_.charged() > max_pending_bytes_ )
+    pruned += drop_farthest( pending_account_.charged() - max_pending_bytes_ );
+  if ( pruned > 0 ) {
+    stats_.prunes++;
+    stats_.bytes_pruned += pruned;
+  }
+}
+
+uint64_t Reassembler::drop_farthest( uint64_t max_len )
+{
+  uint64_t dropped = 0;
+  switch ( storage_ ) {
+    case Storage::Map: {
+      const auto last = prev( pending_.end() );
+      dropped = min( max_len, static_cast<uint64_t>( last->second.size() ) );
+      if ( dropped == last->second.size() )
+        pending_.erase( last );
+      else
+        last->second.resize( last->second.size() - dropped );
+      break;
+    }
+    case Storage::Ring: {
+      // Skip the absent bytes at the far end of the window, then take from the run before them
+      const uint64_t end = next_index_ + window_.size() - present_run_before( next_index_ + window_.size(), false );
+      const uint64_t len = present_run_before( end );
+      dropped = min( max_len, len );
+      mark_absent( end - dropped, dropped );
+      if ( dropped == len )
+        ring_runs_--;
+      break;
+    }
+    case Storage::Flat: {
+      auto& [start, end] = ranges_.back();
+      dropped = min( max_len, end - start );
+      end -= dropped;
+      if ( start == end )
+        ranges_.pop_back();
+      break;
+    }
+    case Storage::Slices: {
+      const auto last = prev( slices_.end() );
+      auto& bytes = last->second.bytes;
+      dropped = min( max_len, static_cast<uint64_t>( bytes.size() ) );
+      if ( dropped < bytes.size() ) {
+        bytes.remove_suffix( dropped );
+      } else {
+        // The run ends here unless the slice before this one touches it
+        if ( last == slices_.begin() || prev( last )->first + prev( last )->second.bytes.size() < last->first )
+          slice_runs_--;
+        slices_.erase( last );
+      }
+      break;
+    }
+  }
+  pending_account_.release( dropped );
+  return dropped;
 }
 
 // How many bytes are stored in the Reassembler itself?
-// This function is for testing only; don't add extra state to support it.
 uint64_t Reassembler::count_bytes_pending() const
 {
-  uint64_t count = 0;
-  for ( const auto& [index, data] : pending_ )
-    count += data.size();
-  return count;
+  return pending_account_.charged();
 }
@@ -1,13 +1,40 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "memory_budget.hh"
+
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 class Reassembler
 {
 public:
-  // Construct Reassembler to write into given ByteStream.
-  explicit Reassembler( ByteStream&& output ) : output_( std::move( output ) ) {}
+  // How the Reassembler keeps the bytes it can't write yet
+  enum class Storage : uint8_t
+  {
+    Map,   // one string per stored range, in an ordered map; neighbouring ranges are merged by appending
+    Ring,  // a window the size of the stream's capacity, plus a bitmap of which bytes of it are present
+    Flat,  // the same window, plus a sorted vector of the [start, end) ranges stored in it
+    Slices // references to the parts of the inserted (shared) strings that are stored, by first index
+  };
+
+  static std::string_view storage_name( Storage storage ); // e.g. "map", for reports and test descriptions
+
+  // Construct Reassembler to write into given ByteStream, optionally charging the bytes it holds to `budget`.
+  explicit Reassembler( ByteStream&& output, std::shared_ptr<MemoryBudget> budget = {} )
+    : Reassembler( std::move( output ), Storage::Map, std::move( budget ) )
+  {}
+
+  Reassembler( ByteStream&& output, Storage storage, std::shared_ptr<MemoryBudget> budget = {} )
+    : output_( std::move( output ) ), storage_( storage ), pending_account_( std::move( budget ) )
+  {}
 
   /*
    * Insert a new substring to be reassembled into a ByteStream.
@@ -31,10 +58,86 @@ public:
    */
   void insert( uint64_t first_index, std::string data, bool is_last_substring );
 
+  /*
+   * Insert a substring held in a shared buffer (e.g. a received payload), as insert() does. With
+   * Storage::Slices, the Reassembler keeps references into `data` instead of copies of the bytes it stores,
+   * even when they are split up to fill several holes, so each byte is copied only once: into the stream.
+   * (A buffer stays alive as long as any of its bytes are stored, which can be more memory than the bytes
+   * pending.) Other storages copy what they keep.
+   */
+  void insert( uint64_t first_index, std::shared_ptr<const std::string> data, bool is_last_substring );
+
+  // One substring for insert_many()
+  struct Substring
+  {
+    uint64_t first_index;
+    std::string data;
+    bool is_last_substring;
+  };
+
+  /*
+   * Insert a batch of substrings (e.g. a burst of received segments) as if each were passed to insert()
+   * in order of first index; stats() counts what that would have. The batch is sorted and overlapping or
+   * adjacent substrings are merged into runs, which are then inserted nearest first, so the pending storage
+   * is visited once per run rather than once per substring. The substrings' data is moved from.
+   */
+  void insert_many( std::span<Substring> substrings );
+
+  /*
+   * Fast path for a substring that starts at the next expected index, when nothing is stored and the
+   * whole substring fits in the stream (see has_pending() and the Writer's available_capacity()):
+   * the bytes go straight to the output without touching the pending storage.
+   */
+  void insert_in_order( std::string data );
+
+  // Are any bytes stored, waiting for earlier bytes to arrive?
+  bool has_pending() const { return pending_account_.charged() > 0; }
+
+  // The index of the next byte the stream is waiting for
+  uint64_t next_index() const { return next_index_; }
+
   // How many bytes are stored in the Reassembler itself?
-  // This function is for testing only; don't add extra state to support it.
   uint64_t count_bytes_pending() const;
 
+  // Operational counters, e.g. to see a path start reordering
+  struct Stats
+  {
+    uint64_t holes;                     // Gaps before stored bytes right now (one per run of stored bytes)
+    uint64_t max_out_of_order_distance; // Furthest a substring has started past the next expected index
+    uint64_t bytes_discarded;           // Bytes dropped because they were beyond the stream's capacity
+    uint64_t duplicate_bytes;           // Bytes that had already been written or stored when they arrived
+    uint64_t merges;                    // Times a stored run was joined onto another
+    uint64_t prunes;                    // Inserts after which stored bytes were dropped to respect the limits
+    uint64_t bytes_pruned;              // Stored bytes dropped to respect the limits
+  };
+
+  Stats stats() const;
+
+  /*
+   * Cap what the Reassembler holds beyond the next expected index, separately from the stream's capacity:
+   * at most `max_bytes` bytes, in at most `max_runs` separate runs. Whenever an insert leaves more than that,
+   * the bytes farthest from the next expected index are dropped (as Linux prunes its out-of-order queue),
+   * and the peer will have to send them again.
+   */
+  void set_pending_limits( uint64_t max_bytes, uint64_t max_runs );
+
+  // A run of stored bytes: stream indices [start, end)
+  struct Block
+  {
+    uint64_t start;
+    uint64_t end;
+  };
+
+  /*
+   * The runs of bytes held beyond the next expected index, nearest first (e.g. for the blocks of a TCP
+   * selective acknowledgment). Fills at most `blocks.size()` of them and returns how many it filled.
+   * With Storage::Map and Storage::Flat, the cost grows with the number of blocks asked for, not with the
+   * number stored. Storage::Ring finds the runs by scanning its bitmap a word at a time, and Storage::Slices
+   * walks (and joins up) the stored slices making up the blocks it fills, so there the cost also grows with
+   * how finely the blocks were filled in.
+   */
+  size_t received_blocks( std::span<Block> blocks ) const;
+
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
   const Reader& reader() const { return output_.reader(); }
@@ -42,9 +145,64 @@ public:
   // Access output stream writer, but const-only (can't write from outside)
   const Writer& writer() const { return output_.writer(); }
 
+  // The budget (if any) that the pending bytes are charged to
+  const std::shared_ptr<MemoryBudget>& memory_budget() const { return pending_account_.budget(); }
+
+  Storage storage() const { return storage_; }
+
 private:
+  void insert_map( uint64_t first_index, std::string data );
+  void insert_ring( uint64_t first_index, std::string data );
+  void insert_flat( uint64_t first_index, std::string data );
+  void insert_slices( uint64_t first_index,
+                      const std::shared_ptr<const std::string>& buffer,
+                      std::string_view data );
+
+  // Trim a substring to the bytes after the next expected index that fit in the stream, counting the rest
+  // as duplicate or discarded; return how many bytes to skip from its front and how many to keep, if any
+  std::optional<std::pair<uint64_t, uint64_t>> admit( uint64_t first_index, uint64_t len, bool is_last_substring );
+  void settle( uint64_t known, uint64_t len ); // Count duplicates among `len` admitted bytes, prune, maybe close
+
+  void stash( uint64_t first_index, std::string_view data ); // Ring/Flat: copy `data` into the window
+  void write_from_window( uint64_t len );                    // Ring/Flat: move `len` bytes on to the stream
+
+  // Ring: update the presence bitmap for stream indices [index, index + len); return how many bits changed
+  uint64_t mark_present( uint64_t index, uint64_t len );
+  uint64_t mark_absent( uint64_t index, uint64_t len );
+  uint64_t present_run( uint64_t index, bool present = true ) const;      // Ring: run of present (absent) bytes
+  uint64_t present_run_before( uint64_t end, bool present = true ) const; // Ring: the same, ending at `end`
+  uint64_t runs_overlapping( uint64_t index, uint64_t len ) const;        // Ring: present runs touching the range
+  bool is_present( uint64_t index ) const;
+
+  uint64_t add_range( uint64_t start, uint64_t end ); // Flat: store [start, end); return how many bytes are new
+  void drop_front_ranges( uint64_t count );           // Flat: forget the first `count` stored ranges
+
+  uint64_t stored_runs() const;
+  uint64_t drop_farthest( uint64_t max_len ); // Drop up to `max_len` bytes off the end of the farthest run
+  void prune();                               // Drop the farthest bytes until the pending limits are respected
+
   ByteStream output_;
-  std::map<uint64_t, std::string> pending_ {};
+  Storage storage_;
+  std::map<uint64_t, std::string> pending_ {};           // Map: stored ranges by first index, disjoint
+  std::string window_ {};                                // Ring/Flat: stream byte `i` lives at `i % capacity`
+  std::vector<uint64_t> present_ {};                     // Ring: one bit per byte of `window_`, set if stored
+  std::vector<std::pair<uint64_t, uint64_t>> ranges_ {}; // Flat: stored [start, end) ranges, sorted, disjoint
+  uint64_t ranges_head_ {};                              // Flat: the ranges before this one were written out
+
+  // Slices: stored bytes, viewed inside the buffer that brought them
+  struct Slice
+  {
+    std::shared_ptr<const std::string> buffer;
+    std::string_view bytes;
+  };
+  std::map<uint64_t, Slice> slices_ {}; // Slices: stored slices by first index, disjoint (touching ones form a run)
+
+  uint64_t ring_runs_ {};  // Ring: runs of present bytes in `window_`
+  uint64_t slice_runs_ {}; // Slices: runs of touching slices in `slices_`
   uint64_t next_index_ = 0;
   uint64_t last_index_ = -1;
+  uint64_t max_pending_bytes_ = UINT64_MAX;
+  uint64_t max_pending_runs_ = UINT64_MAX;
+  MemoryBudget::Account pending_account_;
+  Stats stats_ {};
 };
@@ -0,0 +1,188 @@
+#include "spsc_byte_stream.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+SPSCByteStream::SPSCByteStream( uint64_t capacity )
+  : capacity_( capacity )
+  , buffer_( make_unique_for_overwrite<char[]>( capacity ) )
+  , reader_event_( make_event() )
+  , writer_event_( make_event() )
+{}
+
+FileDescriptor SPSCByteStream::make_event()
+{
+  return FileDescriptor { CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) };
+}
+
+void SPSCByteStream::notify( const FileDescriptor& event )
+{
+  const uint64_t one = 1;
+  CheckSystemCall( "write", static_cast<int>( ::write( event.fd_num(), &one, sizeof( one ) ) ) );
+}
+
+void SPSCByteStream::wait_for( const FileDescriptor& event )
+{
+  pollfd pfd { event.fd_num(), POLLIN, 0 };
+  if ( ::poll( &pfd, 1, -1 ) < 0 ) {
+    if ( errno == EINTR ) {
+      return; // the caller re-checks the stream and waits again if needed
+    }
+    throw unix_error { "poll" };
+  }
+  clear( event );
+}
+
+void SPSCByteStream::clear( const FileDescriptor& event )
+{
+  // Reset the eventfd counter. EAGAIN is fine: a spurious wakeup just means one more check of the stream.
+  uint64_t count {};
+  if ( ::read( event.fd_num(), &count, sizeof( count ) ) < 0 && errno != EAGAIN ) {
+    throw unix_error { "read" };
+  }
+}
+
+uint64_t SPSCByteStream::push( string_view data )
+{
+  const uint64_t pushed = bytes_pushed_.load( memory_order_relaxed );
+  const uint64_t popped = bytes_popped_.load( memory_order_acquire );
+  const uint64_t len = min( static_cast<uint64_t>( data.size() ), capacity_ - ( pushed - popped ) );
+  if ( len == 0 ) {
+    return 0;
+  }
+
+  const uint64_t tail = pushed % capacity_;
+  const uint64_t first_part = min( len, capacity_ - tail );
+  copy_n( data.data(), first_part, buffer_.get() + tail );
+  copy_n( data.data() + first_part, len - first_part, buffer_.get() );
+  bytes_pushed_.store( pushed + len, memory_order_release );
+
+  // Pairs with the fence in wait_readable(): either the reader sees the new bytes, or we see it waiting.
+  atomic_thread_fence( memory_order_seq_cst );
+  if ( reader_waiting_.load( memory_order_relaxed ) && reader_waiting_.exchange( false ) ) {
+    notify( reader_event_ );
+  }
+  return len;
+}
+
+void SPSCByteStream::close()
+{
+  closed_.store( true, memory_order_release );
+  atomic_thread_fence( memory_order_seq_cst );
+  if ( reader_waiting_.exchange( false ) ) {
+    notify( reader_event_ );
+  }
+}
+
+void SPSCByteStream::set_error()
+{
+  error_.store( true, memory_order_release );
+  atomic_thread_fence( memory_order_seq_cst );
+  if ( reader_waiting_.exchange( false ) ) {
+    notify( reader_event_ );
+  }
+  if ( writer_waiting_.exchange( false ) ) {
+    notify( writer_event_ );
+  }
+}
+
+uint64_t SPSCByteStream::available_capacity() const
+{
+  return capacity_ - ( bytes_pushed_.load( memory_order_relaxed ) - bytes_popped_.load( memory_order_acquire ) );
+}
+
+uint64_t SPSCByteStream::bytes_pushed() const
+{
+  return bytes_pushed_.load( memory_order_acquire );
+}
+
+void SPSCByteStream::wait_writable()
+{
+  while ( available_capacity() == 0 && !has_error() ) {
+    writer_waiting_.store( true, memory_order_relaxed );
+    atomic_thread_fence( memory_order_seq_cst );
+    if ( available_capacity() || has_error() ) {
+      writer_waiting_.store( false, memory_order_relaxed );
+      return;
+    }
+    wait_for( writer_event_ );
+  }
+}
+
+string_view SPSCByteStream::peek() const
+{
+  const uint64_t buffered = bytes_buffered();
+  if ( buffered == 0 ) {
+    return {};
+  }
+  const uint64_t head = bytes_popped_.load( memory_order_relaxed ) % capacity_;
+  return { buffer_.get() + head, min( buffered, capacity_ - head ) };
+}
+
+void SPSCByteStream::pop( uint64_t len )
+{
+  len = min( len, bytes_buffered() );
+  bytes_popped_.store( bytes_popped_.load( memory_order_relaxed ) + len, memory_order_release );
+
+  // Pairs with the fence in wait_writable(), as in push().
+  atomic_thread_fence( memory_order_seq_cst );
+  if ( writer_waiting_.load( memory_order_relaxed ) && writer_waiting_.exchange( false ) ) {
+    notify( writer_event_ );
+  }
+}
+
+bool SPSCByteStream::is_finished() const
+{
+  // Check `closed_` first: once it is seen, every byte pushed before close() is visible too.
+  return is_closed() && bytes_buffered() == 0;
+}
+
+uint64_t SPSCByteStream::bytes_buffered() const
+{
+  return bytes_pushed_.load( memory_order_acquire ) - bytes_popped_.load( memory_order_relaxed );
+}
+
+uint64_t SPSCByteStream::bytes_popped() const
+{
+  return bytes_popped_.load( memory_order_acquire );
+}
+
+void SPSCByteStream::wait_readable()
+{
+  while ( bytes_buffered() == 0 && !is_closed() && !has_error() ) {
+    reader_waiting_.store( true, memory_order_relaxed );
+    atomic_thread_fence( memory_order_seq_cst );
+    if ( bytes_buffered() || is_closed() || has_error() ) {
+      reader_waiting_.store( false, memory_order_relaxed );
+      return;
+    }
+    wait_for( reader_event_ );
+  }
+}
+
+void SPSCByteStream::arm_reader_event()
+{
+  clear( reader_event_ );
+  reader_waiting_.store( true, memory_order_relaxed );
+  atomic_thread_fence( memory_order_seq_cst ); // As in wait_readable()
+  if ( ( bytes_buffered() || is_closed() || has_error() ) && reader_waiting_.exchange( false ) ) {
+    notify( reader_event_ );
+  }
+}
+
+void SPSCByteStream::arm_writer_event()
+{
+  clear( writer_event_ );
+  writer_waiting_.store( true, memory_order_relaxed );
+  atomic_thread_fence( memory_order_seq_cst ); // As in wait_writable()
+  if ( ( available_capacity() || has_error() ) && writer_waiting_.exchange( false ) ) {
+    notify( writer_event_ );
+  }
+}
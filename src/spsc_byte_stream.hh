@@ -0,0 +1,85 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/*
+ * SPSCByteStream: a fixed-capacity ByteStream that one producer thread and one consumer thread
+ * can share without locks.
+ *
+ * The byte counts are atomics: the producer publishes `bytes_pushed` with release ordering after
+ * copying bytes into the ring, and the consumer publishes `bytes_popped` the same way after it is
+ * done with them, so each side only ever reads bytes the other side has finished with.
+ *
+ * A side that finds nothing to do can sleep on an eventfd: wait_readable() / wait_writable(), or,
+ * from an EventLoop, arm_reader_event() / arm_writer_event() and then poll reader_event() /
+ * writer_event(). The other side only pays for the eventfd write when someone is actually asleep.
+ */
+class SPSCByteStream
+{
+public:
+  explicit SPSCByteStream( uint64_t capacity );
+
+  // Producer side (call from one thread only)
+  uint64_t push( std::string_view data ); // Push as much of `data` as fits; returns the number of bytes pushed
+  void close();                           // Signal that nothing more will be written
+  uint64_t available_capacity() const;    // How many bytes can be pushed right now?
+  uint64_t bytes_pushed() const;          // Total number of bytes cumulatively pushed
+  void wait_writable();                   // Block until there is capacity available (or the stream has an error)
+
+  // Consumer side (call from one thread only)
+  std::string_view peek() const;   // Peek at the next contiguous bytes in the buffer
+  void pop( uint64_t len );        // Remove `len` bytes from the buffer
+  bool is_finished() const;        // Is the stream finished (closed and fully popped)?
+  uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
+  uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped
+  void wait_readable();            // Block until there are bytes to read, or the stream is finished
+
+  // Either side
+  bool is_closed() const { return closed_.load( std::memory_order_acquire ); }
+  void set_error();
+  bool has_error() const { return error_.load( std::memory_order_acquire ); }
+  uint64_t capacity() const { return capacity_; }
+
+  // Become readable when the consumer (resp. producer) should look at the stream again, once armed
+  const FileDescriptor& reader_event() const { return reader_event_; }
+  const FileDescriptor& writer_event() const { return writer_event_; }
+
+  // For polling the events: clear the event, then have the other side signal it once there is something
+  // to do (bytes to read, or the stream closed or in error; resp. capacity available or an error). If there
+  // already is, the event is signalled right away. Call again each time the stream has been handled.
+  void arm_reader_event();
+  void arm_writer_event();
+
+  // The producer and consumer threads work on this one object, so it has to stay put until both are done
+  SPSCByteStream( const SPSCByteStream& other ) = delete;
+  SPSCByteStream& operator=( const SPSCByteStream& other ) = delete;
+  SPSCByteStream( SPSCByteStream&& other ) = delete;
+  SPSCByteStream& operator=( SPSCByteStream&& other ) = delete;
+  ~SPSCByteStream() = default;
+
+private:
+  uint64_t capacity_;
+  std::unique_ptr<char[]> buffer_;
+
+  // Each count is written by one side only. Keep them on separate cache lines so the two threads
+  // don't invalidate each other's line on every push and pop.
+  alignas( 64 ) std::atomic<uint64_t> bytes_pushed_ {};
+  alignas( 64 ) std::atomic<uint64_t> bytes_popped_ {};
+  alignas( 64 ) std::atomic<bool> closed_ {};
+  std::atomic<bool> error_ {};
+  std::atomic<bool> reader_waiting_ {};
+  std::atomic<bool> writer_waiting_ {};
+
+  FileDescriptor reader_event_;
+  FileDescriptor writer_event_;
+
+  static FileDescriptor make_event();
+  static void notify( const FileDescriptor& event );
+  static void clear( const FileDescriptor& event );
+  static void wait_for( const FileDescriptor& event );
+};
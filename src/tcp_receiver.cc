@@ -5,6 +5,19 @@ using namespace std;
 
 void TCPReceiver::receive( TCPSenderMessage message )
 {
+  segments_received_++;
+
+  // Header prediction: a plain data segment carrying exactly the next expected bytes, which all fit, with
+  // nothing waiting in the Reassembler, goes straight to the stream (no unwrap, no pending-storage lookup).
+  if ( SYN_received_ && !message.SYN && !message.FIN && !message.RST
+       && message.seqno == zero_point_ + static_cast<uint32_t>( reassembler_.next_index() + 1 )
+       && !reassembler_.has_pending() && !reassembler_.writer().is_closed()
+       && message.payload.size() <= reassembler_.writer().available_capacity() ) {
+    fast_path_hits_++;
+    reassembler_.insert_in_order( move( message.payload ) );
+    return;
+  }
+
   if ( message.RST ) {
     reassembler_.reader().set_error();
     return;
@@ -22,11 +35,11 @@ void TCPReceiver::receive( TCPSenderMessage message )
       return;
     first_index--;
   }
-  reassembler_.insert( first_index, message.payload, message.FIN );
   if ( message.FIN ) {
     FIN_received_ = true;
     last_index_ = first_index + message.payload.size();
   }
+  reassembler_.insert( first_index, move( message.payload ), message.FIN );
 }
 
 TCPReceiverMessage TCPReceiver::send() const
@@ -39,6 +52,9 @@ TCPReceiverMessage TCPReceiver::send() const
     msg.ackno = zero_point_ + absolute_ackno;
   }
   msg.window_size = min( 65535ul, reassembler_.writer().available_capacity() );
+  // Under memory pressure, don't invite the peer to send more than the shared budget has room for.
+  if ( reassembler_.memory_budget() )
+    msg.window_size = min( static_cast<uint64_t>( msg.window_size ), reassembler_.memory_budget()->available() );
   msg.RST = reassembler_.writer().has_error();
   return msg;
 }
@@ -25,10 +25,16 @@ public:
   const Reader& reader() const { return reassembler_.reader(); }
   const Writer& writer() const { return reassembler_.writer(); }
 
+  // How many segments have been received, and how many of those took the in-order fast path?
+  uint64_t segments_received() const { return segments_received_; }
+  uint64_t fast_path_hits() const { return fast_path_hits_; }
+
 private:
   Reassembler reassembler_;
   Wrap32 zero_point_ { 0 };
   bool SYN_received_ { false };
   bool FIN_received_ { false };
   uint64_t last_index_ {};
+  uint64_t segments_received_ {};
+  uint64_t fast_path_hits_ {};
 };
@@ -4,13 +4,10 @@
 
 using namespace std;
 
-// This function is for testing only; don't add extra state to support it.
+// Kept as a running count: TCPPeer::active() and the socket's event loop ask on every pass.
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
-  uint64_t count = 0;
-  for ( const auto& p : outstanding_ )
-    count += p.second.sequence_length();
-  return count;
+  return sequence_numbers_in_flight_;
 }
 
 // This function is for testing only; don't add extra state to support it.
@@ -19,37 +16,95 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return consecutive_retransmissions_;
 }
 
+uint64_t TCPSender::window() const
+{
+  // A zero window is treated as one, to probe it
+  const uint64_t window = max( uint64_t { 1 }, static_cast<uint64_t>( rcv_wnd_ ) );
+  if ( !congestion_control_ )
+    return window;
+  return min( window, in_recovery_ ? recovery_cwnd_ : congestion_control_->cwnd() );
+}
+
+// RFC 6298's smoothing (only the estimate is kept: the RTO stays as configured)
+void TCPSender::sample_rtt( uint64_t rtt_ms )
+{
+  smoothed_rtt_ms_ = smoothed_rtt_ms_ ? ( 7 * *smoothed_rtt_ms_ + rtt_ms ) / 8 : rtt_ms;
+  if ( congestion_control_ )
+    congestion_control_->on_rtt_sample( rtt_ms );
+}
+
+void TCPSender::set_pacing( uint64_t burst_segments )
+{
+  pacing_ = true;
+  pacing_burst_ = max( burst_segments, uint64_t { 1 } );
+}
+
+uint64_t TCPSender::pacing_interval_us( uint64_t length ) const
+{
+  if ( !smoothed_rtt_ms_ )
+    return 0;
+  const bool slow_start = congestion_control_ && congestion_control_->cwnd() < congestion_control_->ssthresh();
+  const uint64_t percent = slow_start ? 200 : 120;
+  return length * *smoothed_rtt_ms_ * 1000 * 100 / ( window() * percent );
+}
+
+void TCPSender::set_fast_retransmit( bool enabled )
+{
+  fast_retransmit_ = enabled;
+}
+
 void TCPSender::push( const TransmitFunction& transmit )
 {
-  while ( next_abs_seqno_to_send_ < last_abs_ack_received_ + max( 1, static_cast<int>( rcv_wnd_ ) )
-          && !FIN_sent_ ) {
+  // Fast retransmit, or a partial ACK in fast recovery: resend the first unacknowledged segment
+  if ( retransmit_first_ && !outstanding_.empty() ) {
+    transmit( outstanding_.front().second );
+    rtt_timing_ = false;
+  }
+  retransmit_first_ = false;
+
+  pacing_deferred_ = false;
+  while ( next_abs_seqno_to_send_ < last_abs_ack_received_ + window() && !FIN_sent_ ) {
+    if ( pacing_ && next_release_us_ > now_ms_ * 1000 ) {
+      pacing_deferred_ = true; // tick() sends it once its release time comes
+      break;
+    }
     TCPSenderMessage msg;
     msg.seqno = Wrap32::wrap( next_abs_seqno_to_send_, isn_ );
     const uint64_t bytes_to_read = min( min( TCPConfig::MAX_PAYLOAD_SIZE, reader().bytes_buffered() ),
-                                        last_abs_ack_received_ + max( 1, static_cast<int>( rcv_wnd_ ) )
-                                          - next_abs_seqno_to_send_ - !SYN_sent_ );
+                                        last_abs_ack_received_ + window() - next_abs_seqno_to_send_ - !SYN_sent_ );
     msg.SYN = !SYN_sent_;
     SYN_sent_ = true;
-    if ( bytes_to_read ) {
-      msg.payload = reader().peek().substr( 0, bytes_to_read );
-      reader().pop( bytes_to_read );
-    }
-    if ( next_abs_seqno_to_send_ + msg.sequence_length()
-           < last_abs_ack_received_ + max( 1, static_cast<int>( rcv_wnd_ ) )
+    // (peek() may show only part of what's buffered, e.g. up to the end of the ring or the front page)
+    read( reader(), bytes_to_read, msg.payload );
+    if ( next_abs_seqno_to_send_ + msg.sequence_length() < last_abs_ack_received_ + window()
          && reader().is_finished() ) {
       msg.FIN = true;
       FIN_sent_ = true;
     }
     msg.RST = reader().has_error();
-    if ( msg.sequence_length() ) {
+    const uint64_t length = msg.sequence_length();
+    if ( length ) {
       transmit( msg );
-      outstanding_.insert( { next_abs_seqno_to_send_, msg } );
+      outstanding_.emplace_back( next_abs_seqno_to_send_, move( msg ) );
+      sequence_numbers_in_flight_ += length;
+      if ( !rtt_timing_ ) {
+        rtt_timing_ = true;
+        rtt_timed_ackno_ = next_abs_seqno_to_send_ + length;
+        rtt_timed_sent_ms_ = now_ms_;
+      }
+      if ( pacing_ ) {
+        // Credit left over from an idle spell lets a short burst out back to back, but no more
+        const uint64_t now_us = now_ms_ * 1000;
+        const uint64_t credit_us = pacing_interval_us( ( pacing_burst_ - 1 ) * TCPConfig::MAX_PAYLOAD_SIZE );
+        next_release_us_
+          = max( next_release_us_, now_us - min( now_us, credit_us ) ) + pacing_interval_us( length );
+      }
       if ( !timer_running_ ) {
         timer_running_ = true;
         timer_ = 0;
       }
     }
-    next_abs_seqno_to_send_ += msg.sequence_length();
+    next_abs_seqno_to_send_ += length;
     // If we have nothing to send, 1) we have sent a FIN, 2) the window is full,
     // or 3) the reader has no more buffered bytes, don't try to send more.
     if ( reader().bytes_buffered() == 0 )
@@ -65,27 +120,56 @@ TCPSenderMessage TCPSender::make_empty_message() const
   return msg;
 }
 
-void TCPSender::receive( const TCPReceiverMessage& msg )
+void TCPSender::receive( const TCPReceiverMessage& msg, bool with_data )
 {
+  const uint16_t previous_window = rcv_wnd_;
   rcv_wnd_ = msg.window_size;
   if ( msg.RST )
     reader().set_error();
   if ( !msg.ackno.has_value() )
     return;
   const uint64_t abs_ackno = msg.ackno->unwrap( isn_, reader().bytes_popped() );
-  if ( abs_ackno > next_abs_seqno_to_send_ || abs_ackno <= last_abs_ack_received_ )
+  if ( abs_ackno > next_abs_seqno_to_send_ || abs_ackno < last_abs_ack_received_ )
+    return;
+  if ( abs_ackno == last_abs_ack_received_ ) {
+    // The same ackno and window on a segment without data, while data is outstanding: a duplicate ACK
+    // (RFC 5681); a new window isn't one, and the peer's data segments neither count nor break the run
+    if ( with_data )
+      return;
+    if ( fast_retransmit_ && !outstanding_.empty() && msg.window_size == previous_window )
+      receive_duplicate_ack();
+    else
+      duplicate_acks_ = 0;
     return;
-  auto it = outstanding_.lower_bound( { abs_ackno, TCPSenderMessage() } );
-  if ( it != outstanding_.end() && it->first == abs_ackno ) {
-    outstanding_.erase( outstanding_.begin(), it );
-  } else if ( it != outstanding_.begin() ) {
-    --it;
-    if ( it->first + it->second.sequence_length() <= abs_ackno )
-      ++it;
-    outstanding_.erase( outstanding_.begin(), it );
+  }
+  // Segments are queued in seqno order, so the fully acknowledged ones are at the front
+  while ( !outstanding_.empty()
+          && outstanding_.front().first + outstanding_.front().second.sequence_length() <= abs_ackno ) {
+    sequence_numbers_in_flight_ -= outstanding_.front().second.sequence_length();
+    outstanding_.pop_front();
   }
   if ( outstanding_.empty() )
     timer_running_ = false;
+  if ( rtt_timing_ && abs_ackno >= rtt_timed_ackno_ ) {
+    rtt_timing_ = false;
+    sample_rtt( now_ms_ - rtt_timed_sent_ms_ );
+  }
+  // (The SYN's acknowledgment doesn't grow the congestion window)
+  const uint64_t acked = abs_ackno - max( last_abs_ack_received_, uint64_t { 1 } );
+  if ( in_recovery_ && abs_ackno < recover_ ) {
+    // Partial ACK (RFC 6582): the next hole is lost too. Resend it at once, and deflate the window by what
+    // left the network, allowing one new segment.
+    retransmit_first_ = true;
+    recovery_cwnd_ -= min( recovery_cwnd_, acked );
+    if ( acked >= TCPConfig::MAX_PAYLOAD_SIZE )
+      recovery_cwnd_ += TCPConfig::MAX_PAYLOAD_SIZE;
+  } else if ( in_recovery_ ) {
+    // Full ACK: everything sent before the loss is acknowledged; carry on from ssthresh
+    in_recovery_ = false;
+  } else if ( congestion_control_ && acked > 0 ) {
+    congestion_control_->on_ack( acked, sequence_numbers_in_flight_, now_ms_ );
+  }
+  duplicate_acks_ = 0;
   last_abs_ack_received_ = abs_ackno;
   RTO_ = initial_RTO_ms_;
   if ( !outstanding_.empty() )
@@ -93,14 +177,47 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
   consecutive_retransmissions_ = 0;
 }
 
+void TCPSender::receive_duplicate_ack()
+{
+  ++duplicate_acks_;
+  if ( in_recovery_ ) {
+    // Each duplicate ACK means a segment has left the network: let another one in
+    recovery_cwnd_ += TCPConfig::MAX_PAYLOAD_SIZE;
+    return;
+  }
+  // Three in a row: the segment after the ackno is lost. Resend it and enter fast recovery, unless the
+  // ackno isn't past what was outstanding at the last timeout or loss (RFC 6582's `recover`).
+  if ( duplicate_acks_ < 3 || last_abs_ack_received_ <= recover_ )
+    return;
+  in_recovery_ = true;
+  recover_ = next_abs_seqno_to_send_;
+  retransmit_first_ = true;
+  if ( congestion_control_ ) {
+    congestion_control_->on_loss( sequence_numbers_in_flight_, now_ms_ );
+    recovery_cwnd_ = congestion_control_->cwnd() + 3 * TCPConfig::MAX_PAYLOAD_SIZE;
+  }
+}
+
 void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
 {
+  now_ms_ += ms_since_last_tick;
+  // Send what pacing held back and has come due since
+  if ( pacing_deferred_ )
+    push( transmit );
   if ( !timer_running_ )
     return;
   timer_ += ms_since_last_tick;
   if ( timer_ >= RTO_ ) {
     transmit( outstanding_.begin()->second );
+    rtt_timing_ = false; // The ACK could be for either transmission
+    in_recovery_ = false;
+    retransmit_first_ = false;
+    duplicate_acks_ = 0;
+    recover_ = next_abs_seqno_to_send_;
+    // A timeout while probing a zero window isn't a sign of congestion
     if ( rcv_wnd_ > 0 ) {
+      if ( congestion_control_ )
+        congestion_control_->on_rto( sequence_numbers_in_flight_, now_ms_ );
       RTO_ *= 2;
       ++consecutive_retransmissions_;
     }
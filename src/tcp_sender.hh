@@ -1,11 +1,15 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
+#include <deque>
 #include <functional>
-#include <set>
+#include <memory>
+#include <optional>
+#include <utility>
 
 class TCPSender
 {
@@ -15,11 +19,23 @@ public:
     : input_( std::move( input ) ), isn_( isn ), initial_RTO_ms_( initial_RTO_ms )
   {}
 
+  /* Construct TCP sender that also keeps within the window of the given congestion control (if any) */
+  TCPSender( ByteStream&& input,
+             Wrap32 isn,
+             uint64_t initial_RTO_ms,
+             std::unique_ptr<CongestionControl> congestion_control )
+    : input_( std::move( input ) )
+    , isn_( isn )
+    , initial_RTO_ms_( initial_RTO_ms )
+    , congestion_control_( std::move( congestion_control ) )
+  {}
+
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage make_empty_message() const;
 
-  /* Receive and process a TCPReceiverMessage from the peer's receiver */
-  void receive( const TCPReceiverMessage& msg );
+  /* Receive and process a TCPReceiverMessage from the peer's receiver (`with_data`: it came on a segment that
+     occupies sequence numbers, so it can't be a duplicate ACK) */
+  void receive( const TCPReceiverMessage& msg, bool with_data = false );
 
   /* Type of the `transmit` function that the push and tick methods can use to send messages */
   using TransmitFunction = std::function<void( const TCPSenderMessage& )>;
@@ -30,19 +46,42 @@ public:
   /* Time has passed by the given # of milliseconds since the last time the tick() method was called */
   void tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit );
 
+  /*
+   * Pace transmissions: rather than a whole window at once, send at about the window per smoothed RTT
+   * (twice that in slow start, 1.2 times in congestion avoidance, so pacing doesn't hold back the window's
+   * growth), at most `burst_segments` full segments back to back. Each segment gets a release time, and
+   * tick() sends what has come due. Until the RTT has been sampled, segments go out unpaced.
+   */
+  void set_pacing( uint64_t burst_segments );
+
+  /*
+   * Repair losses without waiting for the retransmission timer: after three duplicate ACKs, resend the
+   * first unacknowledged segment (fast retransmit) and enter NewReno fast recovery (RFC 6582) until all
+   * that was outstanding is acknowledged, resending the next hole at each partial ACK. With congestion
+   * control, the loss sets ssthresh and the window is inflated by one segment per duplicate ACK meanwhile.
+   */
+  void set_fast_retransmit( bool enabled );
+
   // Accessors
-  uint64_t sequence_numbers_in_flight() const;  // For testing: how many sequence numbers are outstanding?
+  uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // For testing: how many consecutive retransmissions have happened?
+  const CongestionControl* congestion_control() const { return congestion_control_.get(); }
+  std::optional<uint64_t> smoothed_rtt_ms() const { return smoothed_rtt_ms_; } // SRTT (RFC 6298), once sampled
   const Writer& writer() const { return input_.writer(); }
   const Reader& reader() const { return input_.reader(); }
   Writer& writer() { return input_.writer(); }
 
 private:
   Reader& reader() { return input_.reader(); }
+  uint64_t window() const; // How far past the last ackno we may send: receiver's window, capped by cwnd
+  void sample_rtt( uint64_t rtt_ms );
+  void receive_duplicate_ack();
+  uint64_t pacing_interval_us( uint64_t length ) const; // How long sending `length` seqnos takes at the pace
 
   ByteStream input_;
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
+  std::unique_ptr<CongestionControl> congestion_control_ {};
 
   uint64_t RTO_ { initial_RTO_ms_ };
   uint16_t rcv_wnd_ = 1;
@@ -52,11 +91,26 @@ private:
   bool FIN_sent_ = false;
   uint64_t timer_ = 0;
   bool timer_running_ = false;
-  const std::function<bool( const std::pair<uint64_t, TCPSenderMessage>&,
-                            const std::pair<uint64_t, TCPSenderMessage>& )>
-    compare = []( const std::pair<uint64_t, TCPSenderMessage>& a, const std::pair<uint64_t, TCPSenderMessage>& b ) {
-      return a.first < b.first;
-    };
-  std::set<std::pair<uint64_t, TCPSenderMessage>, decltype( compare )> outstanding_ { compare };
+  uint64_t now_ms_ = 0; // Sum of all the ticks so far
+  std::deque<std::pair<uint64_t, TCPSenderMessage>> outstanding_ {}; // Sent, not fully acked: by absolute seqno
+  uint64_t sequence_numbers_in_flight_ = 0;                           // Sum of sequence_length() over outstanding_
   uint64_t consecutive_retransmissions_ = 0;
+
+  // Round-trip time: one segment at a time is timed, and never one that was retransmitted (Karn's algorithm)
+  bool rtt_timing_ = false;
+  uint64_t rtt_timed_ackno_ = 0;   // The absolute ackno that acknowledges the timed segment
+  uint64_t rtt_timed_sent_ms_ = 0; // When it was sent
+  std::optional<uint64_t> smoothed_rtt_ms_ {};
+
+  bool pacing_ = false;
+  uint64_t pacing_burst_ = 1;    // Full segments that may be sent back to back
+  uint64_t next_release_us_ = 0; // When the next segment may be sent (in microseconds on the tick() clock)
+  bool pacing_deferred_ = false; // The last push() left something for its release time
+
+  bool fast_retransmit_ = false;
+  uint64_t duplicate_acks_ = 0;   // In a row, for the current ackno
+  bool retransmit_first_ = false; // The next push() resends the first outstanding segment
+  bool in_recovery_ = false;
+  uint64_t recover_ = 0;       // Fast recovery ends when this is acked: next_abs_seqno_to_send_ at the loss
+  uint64_t recovery_cwnd_ = 0; // The congestion window during fast recovery, inflated by duplicate ACKs
 };
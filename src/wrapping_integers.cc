@@ -3,23 +3,22 @@
 
 using namespace std;
 
-Wrap32 Wrap32::wrap( uint64_t n, Wrap32 zero_point )
+// Both loops work on the raw 32-bit values (a load or store of a whole Wrap32 isn't given a vector type)
+
+void Wrap32::wrap_many( span<const uint64_t> n, Wrap32 zero_point, span<Wrap32> out )
 {
-  return Wrap32( static_cast<uint32_t>( n + zero_point.raw_value_ ) );
+  const size_t count = n.size();
+  const uint64_t* __restrict in = n.data();
+  Wrap32* __restrict dst = out.data();
+  for ( size_t i = 0; i < count; ++i )
+    dst[i].raw_value_ = static_cast<uint32_t>( in[i] + zero_point.raw_value_ ); // NOLINT(*-pointer-arithmetic)
 }
 
-uint64_t Wrap32::unwrap( Wrap32 zero_point, uint64_t checkpoint ) const
+void Wrap32::unwrap_many( span<const Wrap32> seqnos, Wrap32 zero_point, uint64_t checkpoint, span<uint64_t> out )
 {
-  uint64_t result = ( checkpoint >> 32 << 32 ) + raw_value_ - zero_point.raw_value_;
-  if ( raw_value_ < zero_point.raw_value_ )
-    result += 1ull << 32;
-  const uint64_t candidata2 = result - ( 1ull << 32 );
-  const uint64_t candidata3 = result + ( 1ull << 32 );
-  if ( result >= ( 1ull << 32 )
-       && min( candidata2 - checkpoint, checkpoint - candidata2 )
-            < min( result - checkpoint, checkpoint - result ) )
-    result = candidata2;
-  if ( min( candidata3 - checkpoint, checkpoint - candidata3 ) < min( result - checkpoint, checkpoint - result ) )
-    result = candidata3;
-  return result;
+  const size_t count = seqnos.size();
+  const Wrap32* __restrict in = seqnos.data();
+  uint64_t* __restrict dst = out.data();
+  for ( size_t i = 0; i < count; ++i )
+    dst[i] = Wrap32 { in[i].raw_value_ }.unwrap( zero_point, checkpoint ); // NOLINT(*-pointer-arithmetic)
 }
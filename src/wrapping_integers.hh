@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 
 /*
  * The Wrap32 type represents a 32-bit unsigned integer that:
@@ -11,10 +12,13 @@
 class Wrap32
 {
 public:
-  explicit Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
+  explicit constexpr Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
 
   /* Construct a Wrap32 given an absolute sequence number n and the zero point. */
-  static Wrap32 wrap( uint64_t n, Wrap32 zero_point );
+  static constexpr Wrap32 wrap( uint64_t n, Wrap32 zero_point )
+  {
+    return Wrap32 { static_cast<uint32_t>( n + zero_point.raw_value_ ) };
+  }
 
   /*
    * The unwrap method returns an absolute sequence number that wraps to this Wrap32, given the zero point
@@ -22,11 +26,37 @@ public:
    *
    * There are many possible absolute sequence numbers that all wrap to the same Wrap32.
    * The unwrap method should return the one that is closest to the checkpoint.
+   * (Of two equally close, the one in the same 2^32 block as the checkpoint.)
    */
-  uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const;
+  constexpr uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const
+  {
+    // Step up from the checkpoint to the next number that wraps to this one, then step back down a whole
+    // wrap if that is closer and doesn't go below zero. There are no branches (the conditions are combined
+    // as integers, all in 32 bits but the one that depends only on the checkpoint), so batches vectorize.
+    const uint32_t offset = raw_value_ - zero_point.raw_value_;
+    const uint32_t low = static_cast<uint32_t>( checkpoint );
+    const uint32_t up = offset - low;
+    const uint32_t next_block = offset < low; // stepping up crosses into the checkpoint's next 2^32 block
+    const uint32_t closer_below
+      = static_cast<uint32_t>( up > ( 1U << 31 ) ) | ( static_cast<uint32_t>( up == ( 1U << 31 ) ) & next_block );
+    const uint32_t can_step_down = static_cast<uint32_t>( checkpoint >= ( uint64_t { 1 } << 32 ) ) | next_block;
+    return checkpoint + up - ( static_cast<uint64_t>( closer_below & can_step_down ) << 32 );
+  }
 
-  Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
-  bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
+  /*
+   * Batch versions for many sequence numbers at once (e.g. a trace, or a scoreboard of segments):
+   * out[i] = wrap( n[i], zero_point ) and out[i] = seqnos[i].unwrap( zero_point, checkpoint ).
+   * `out` must be at least as long as the input. The loops have no branches and no dependence between
+   * elements, so an optimizing compiler turns them into vector code.
+   */
+  static void wrap_many( std::span<const uint64_t> n, Wrap32 zero_point, std::span<Wrap32> out );
+  static void unwrap_many( std::span<const Wrap32> seqnos,
+                           Wrap32 zero_point,
+                           uint64_t checkpoint,
+                           std::span<uint64_t> out );
+
+  constexpr Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
+  constexpr bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
 
 protected:
   uint32_t raw_value_ {};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// Replaces the global operator new and operator delete to count every heap allocation the program makes, and
+// the heap bytes it holds at any moment.
+// Replacement functions can't be inline, so include this header from only one source file of a program.
+
+inline std::atomic<uint64_t> allocations { 0 }; // NOLINT(*-avoid-non-const-global-variables)
+inline std::atomic<uint64_t> heap_bytes { 0 };  // NOLINT(*-avoid-non-const-global-variables)
+
+void* operator new( size_t size )
+{
+  allocations.fetch_add( 1, std::memory_order_relaxed );
+  if ( void* ptr = std::malloc( size ) ) { // NOLINT(*-no-malloc, *-owning-memory)
+    heap_bytes.fetch_add( malloc_usable_size( ptr ), std::memory_order_relaxed );
+    return ptr;
+  }
+  throw std::bad_alloc {};
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  heap_bytes.fetch_sub( malloc_usable_size( ptr ), std::memory_order_relaxed );
+  std::free( ptr ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  heap_bytes.fetch_sub( malloc_usable_size( ptr ), std::memory_order_relaxed );
+  std::free( ptr ); // NOLINT(*-no-malloc, *-owning-memory)
+}
@@ -0,0 +1,237 @@
+#include "allocation_counter.hh"
+#include "byte_stream.hh"
+#include "spsc_byte_stream.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * ByteStream benchmark matrix.
+ *
+ * Sweeps storage engine, capacity, write size, read size and read method (peek+pop vs. the read()
+ * helper), plus a two-thread producer/consumer run over SPSCByteStream, and prints one row per case
+ * as CSV (default) or JSON (--json) so runs can be compared across releases.
+ */
+
+namespace {
+
+constexpr size_t input_len = size_t { 1 } << 24;
+
+struct Case
+{
+  string storage;
+  string reader;
+  size_t capacity;
+  size_t write_size;
+  size_t read_size;
+};
+
+struct Result
+{
+  double seconds;
+  uint64_t operations;
+  uint64_t allocations;
+};
+
+string make_data()
+{
+  default_random_engine rd { 1729 };
+  uniform_int_distribution<char> ud;
+  string ret;
+  ret.reserve( input_len );
+  for ( size_t i = 0; i < input_len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+ByteStream make_stream( const Case& c, const shared_ptr<BufferPool>& pool )
+{
+  if ( c.storage == "chunked" ) {
+    return ByteStream { c.capacity, ByteStream::Storage::Chunked };
+  }
+  if ( c.storage == "paged" ) {
+    return ByteStream { c.capacity, pool };
+  }
+  return ByteStream { c.capacity };
+}
+
+Result run_single_thread( const Case& c, const string& data, string& output_data )
+{
+  // Split the data into segments before writing
+  vector<string> split_data;
+  for ( size_t i = 0; i < data.size(); i += c.write_size ) {
+    split_data.emplace_back( data.substr( i, c.write_size ) );
+  }
+
+  const auto pool = make_shared<BufferPool>();
+  ByteStream bs = make_stream( c, pool );
+  const bool use_read_helper = c.reader == "read";
+  output_data.clear();
+  string chunk;
+  chunk.reserve( c.read_size );
+  size_t next_write = 0;
+  uint64_t operations = 0;
+
+  const uint64_t allocations_before = allocations.load();
+  const auto start_time = steady_clock::now();
+  while ( not bs.reader().is_finished() ) {
+    if ( next_write == split_data.size() ) {
+      if ( not bs.writer().is_closed() ) {
+        bs.writer().close();
+      }
+    } else if ( split_data[next_write].size() <= bs.writer().available_capacity() ) {
+      bs.writer().push( move( split_data[next_write++] ) );
+      ++operations;
+    }
+
+    if ( bs.reader().bytes_buffered() ) {
+      if ( use_read_helper ) {
+        read( bs.reader(), c.read_size, chunk );
+        output_data += chunk;
+      } else {
+        auto peeked = bs.reader().peek().substr( 0, c.read_size );
+        output_data += peeked;
+        bs.reader().pop( peeked.size() );
+      }
+      ++operations;
+    }
+  }
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations_after = allocations.load();
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  return { duration_cast<duration<double>>( stop_time - start_time ).count(),
+           operations,
+           allocations_after - allocations_before };
+}
+
+Result run_two_threads( const Case& c, const string& data, string& output_data )
+{
+  SPSCByteStream stream { c.capacity };
+  output_data.clear();
+  uint64_t consumer_operations = 0;
+
+  const uint64_t allocations_before = allocations.load();
+  const auto start_time = steady_clock::now();
+  uint64_t producer_operations = 0;
+  thread producer { [&] {
+    const string_view input { data };
+    for ( size_t pushed = 0; pushed < input.size(); ++producer_operations ) {
+      stream.wait_writable();
+      pushed += stream.push( input.substr( pushed, c.write_size ) );
+    }
+    stream.close();
+  } };
+  while ( not stream.is_finished() ) {
+    stream.wait_readable();
+    const auto peeked = stream.peek().substr( 0, c.read_size );
+    output_data += peeked;
+    stream.pop( peeked.size() );
+    ++consumer_operations;
+  }
+  producer.join();
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations_after = allocations.load();
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read (two threads)" );
+  }
+
+  return { duration_cast<duration<double>>( stop_time - start_time ).count(),
+           producer_operations + consumer_operations,
+           allocations_after - allocations_before };
+}
+
+void print_row( bool json, bool first, const Case& c, const Result& r )
+{
+  const auto bytes = static_cast<double>( input_len );
+  const double gigabits_per_second = 8.0 * bytes / r.seconds / 1e9;
+  const double ns_per_op = r.seconds * 1e9 / static_cast<double>( r.operations );
+  const double allocations_per_mb = static_cast<double>( r.allocations ) / ( bytes / 1e6 );
+
+  ostringstream row;
+  row << fixed << setprecision( 3 );
+  if ( json ) {
+    row << ( first ? "  " : ", " ) << "{\"storage\": \"" << c.storage << "\", \"reader\": \"" << c.reader
+        << "\", \"capacity\": " << c.capacity << ", \"write_size\": " << c.write_size
+        << ", \"read_size\": " << c.read_size << ", \"bytes\": " << input_len
+        << ", \"gbit_per_s\": " << gigabits_per_second << ", \"ns_per_op\": " << ns_per_op
+        << ", \"allocs_per_mb\": " << allocations_per_mb << "}\n";
+  } else {
+    row << c.storage << "," << c.reader << "," << c.capacity << "," << c.write_size << "," << c.read_size << ","
+        << input_len << "," << gigabits_per_second << "," << ns_per_op << "," << allocations_per_mb << "\n";
+  }
+  cout << row.str() << flush;
+}
+
+void program_body( bool json )
+{
+  const string data = make_data();
+
+  // One output buffer for every case, already paged in, so no case pays to fault it in
+  string output_data( data.size(), 0 );
+
+  vector<Case> cases;
+  for ( const size_t capacity : { size_t { 4096 }, size_t { 65536 }, size_t { 1 } << 20, size_t { 1 } << 24 } ) {
+    for ( const size_t write_size : { size_t { 1500 }, size_t { 4096 } } ) {
+      for ( const size_t read_size : { size_t { 32 }, size_t { 1500 }, size_t { 65536 } } ) {
+        for ( const string_view storage : { "ring", "chunked", "paged" } ) {
+          for ( const string_view reader : { "peek", "read" } ) {
+            cases.push_back( { string { storage }, string { reader }, capacity, write_size, read_size } );
+          }
+        }
+        cases.push_back( { "spsc", "two_threads", capacity, write_size, read_size } );
+      }
+    }
+  }
+
+  if ( json ) {
+    cout << "[\n";
+  } else {
+    cout << "storage,reader,capacity,write_size,read_size,bytes,gbit_per_s,ns_per_op,allocs_per_mb\n";
+  }
+
+  bool first = true;
+  for ( const auto& c : cases ) {
+    const Result r
+      = c.storage == "spsc" ? run_two_threads( c, data, output_data ) : run_single_thread( c, data, output_data );
+    print_row( json, first, c, r );
+    first = false;
+  }
+
+  if ( json ) {
+    cout << "]\n";
+  }
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    const bool json = argc > 1 and string_view { argv[1] } == "--json"; // NOLINT(*-pointer-arithmetic)
+    program_body( json );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
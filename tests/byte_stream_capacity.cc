@@ -2,6 +2,7 @@
 
 #include <exception>
 #include <iostream>
+#include <memory>
 
 using namespace std;
 
@@ -96,6 +97,33 @@ int main()
       test.execute( BytesBuffered { 1 } );
     }
 
+    {
+      ByteStreamTestHarness test { "watermarks", 10 };
+      const auto crossings = make_shared<Crossings>();
+
+      test.execute( SetWatermarks { 4, 8, crossings } );
+      test.execute( Push { "abcdefg" } );
+      test.execute( WatermarkCrossings { crossings, 0, 0 } );
+      test.execute( Push { "h" } );
+      test.execute( WatermarkCrossings { crossings, 0, 1 } );
+      test.execute( Push { "ijklmnop" } );
+      test.execute( WatermarkCrossings { crossings, 0, 1 } );
+      test.execute( Pop { 1 } );
+      test.execute( Pop { 4 } );
+      test.execute( WatermarkCrossings { crossings, 0, 1 } );
+      test.execute( BytesBuffered { 5 } );
+      test.execute( Push { "kl" } );
+      test.execute( Pop { 3 } );
+      test.execute( WatermarkCrossings { crossings, 1, 1 } );
+      test.execute( BytesBuffered { 4 } );
+      test.execute( Pop { 4 } );
+      test.execute( WatermarkCrossings { crossings, 1, 1 } );
+      test.execute( Push { "qrstuvwxyz" } );
+      test.execute( WatermarkCrossings { crossings, 1, 2 } );
+      test.execute( ReadAll { "qrstuvwxyz" } );
+      test.execute( WatermarkCrossings { crossings, 2, 2 } );
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
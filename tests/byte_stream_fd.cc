@@ -0,0 +1,86 @@
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <array>
+#include <climits>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+pair<FileDescriptor, FileDescriptor> make_pipe()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// More one-byte chunks than writev() takes at once: write_to() writes IOV_MAX of them, then the rest
+void write_to_many_chunks()
+{
+  const size_t chunks = IOV_MAX * 2 + 5;
+  ByteStream stream { chunks, ByteStream::Storage::Chunked };
+  string expected;
+  for ( size_t i = 0; i < chunks; ++i ) {
+    expected += static_cast<char>( 'a' + i % 26 );
+    stream.writer().push( expected.substr( i ) );
+  }
+
+  auto [read_end, write_end] = make_pipe();
+  if ( stream.reader().write_to( write_end ) != IOV_MAX ) {
+    throw runtime_error( "write_to() should write one byte per piece, up to IOV_MAX pieces" );
+  }
+  while ( stream.reader().bytes_buffered() > 0 ) {
+    stream.reader().write_to( write_end );
+  }
+  write_end.close();
+
+  string output;
+  string buffer;
+  while ( not read_end.eof() ) {
+    read_end.read( buffer );
+    output += buffer;
+  }
+  if ( output != expected ) {
+    throw runtime_error( "write_to() wrote the wrong bytes from a chunked stream" );
+  }
+}
+
+// A reservation spanning more pages than readv() takes at once
+void read_from_many_pages()
+{
+  const auto pool = make_shared<BufferPool>( 4096 );
+  ByteStream stream { uint64_t { 16 } << 20, pool };
+  auto [read_end, write_end] = make_pipe();
+  write_end.write( "hello" );
+  write_end.close();
+
+  if ( stream.writer().read_from( read_end ) != 5 or stream.reader().peek() != "hello" ) {
+    throw runtime_error( "read_from() into a paged stream should read what the pipe holds" );
+  }
+  stream.writer().read_from( read_end );
+  if ( not stream.writer().is_closed() or stream.reader().bytes_buffered() != 5 ) {
+    throw runtime_error( "read_from() should close the stream at EOF" );
+  }
+}
+
+int main()
+{
+  try {
+    write_to_many_chunks();
+    read_from_many_pages();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,52 @@
+#include "allocation_counter.hh"
+#include "byte_stream.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// (This test counts heap bytes by replacing operator new, so it is built without the sanitizers.)
+
+// A chunked stream's chunks hold only the bytes committed to them, however much was reserved
+void chunked_reservation_test()
+{
+  ByteStream stream { 64000, ByteStream::Storage::Chunked };
+  const uint64_t heap_before = heap_bytes.load();
+  const auto expect_heap = [&]( const string& after ) {
+    const uint64_t held = heap_bytes.load() - heap_before;
+    if ( held > 64000 ) {
+      throw runtime_error( "chunked ByteStream holds " + to_string( held ) + " heap bytes for "
+                           + to_string( stream.reader().bytes_buffered() ) + " bytes buffered after " + after );
+    }
+  };
+
+  for ( int i = 0; i < 500; ++i ) {
+    const auto spans = stream.writer().reserve( stream.writer().available_capacity() );
+    fill_n( spans.front().data(), 10, 'x' );
+    stream.writer().commit( 10 );
+  }
+  expect_heap( "500 commits of 10 bytes into 64000-byte reservations" );
+
+  stream.writer().reserve( 64000 );
+  stream.writer().commit( 0 );
+  expect_heap( "commit(0)" );
+}
+
+
+int main()
+{
+  try {
+    chunked_reservation_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
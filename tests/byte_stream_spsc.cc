@@ -0,0 +1,144 @@
+#include "spsc_byte_stream.hh"
+
+#include <iostream>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+void two_thread_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
+                      const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                      const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  const string data = [&] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SPSCByteStream stream { capacity };
+
+  thread producer { [&] {
+    default_random_engine rd { random_seed + 1 };
+    uniform_int_distribution<size_t> write_size { 1, capacity * 2 };
+    size_t pushed = 0;
+    while ( pushed < data.size() ) {
+      stream.wait_writable();
+      pushed += stream.push( string_view { data }.substr( pushed, write_size( rd ) ) );
+    }
+    stream.close();
+  } };
+
+  string output;
+  default_random_engine rd { random_seed + 2 };
+  uniform_int_distribution<size_t> read_size { 1, capacity * 2 };
+  while ( not stream.is_finished() ) {
+    stream.wait_readable();
+    const auto peeked = stream.peek().substr( 0, read_size( rd ) );
+    output += peeked;
+    stream.pop( peeked.size() );
+  }
+
+  producer.join();
+
+  if ( output != data ) {
+    throw runtime_error( "SPSCByteStream: mismatch between data written and read (input=" + to_string( input_len )
+                         + ", capacity=" + to_string( capacity ) + ")" );
+  }
+  if ( stream.bytes_pushed() != input_len or stream.bytes_popped() != input_len ) {
+    throw runtime_error( "SPSCByteStream: wrong byte counts after transfer" );
+  }
+}
+
+void single_thread_test()
+{
+  SPSCByteStream stream { 4 };
+
+  if ( stream.push( "abcdef" ) != 4 or stream.available_capacity() != 0 or stream.bytes_buffered() != 4 ) {
+    throw runtime_error( "SPSCByteStream: push() should stop at capacity" );
+  }
+  stream.pop( 3 );
+  if ( stream.push( "gh" ) != 2 or stream.peek() != "d" ) {
+    throw runtime_error( "SPSCByteStream: peek() should stop at the end of the ring" );
+  }
+  stream.pop( 1 );
+  if ( stream.peek() != "gh" ) {
+    throw runtime_error( "SPSCByteStream: peek() should continue from the start of the ring" );
+  }
+  stream.close();
+  if ( stream.is_finished() ) {
+    throw runtime_error( "SPSCByteStream: stream finished with bytes still buffered" );
+  }
+  stream.pop( 2 );
+  stream.wait_readable(); // must not block on a finished stream
+  if ( not stream.is_finished() ) {
+    throw runtime_error( "SPSCByteStream: stream should be finished" );
+  }
+}
+
+bool signalled( const FileDescriptor& event )
+{
+  pollfd pfd { event.fd_num(), POLLIN, 0 };
+  return ::poll( &pfd, 1, 0 ) == 1 and ( pfd.revents & POLLIN );
+}
+
+// The events, polled as an EventLoop would
+void event_test()
+{
+  SPSCByteStream stream { 4 };
+
+  stream.arm_reader_event();
+  if ( signalled( stream.reader_event() ) ) {
+    throw runtime_error( "SPSCByteStream: reader event signalled with nothing to read" );
+  }
+  stream.push( "abcd" );
+  if ( not signalled( stream.reader_event() ) ) {
+    throw runtime_error( "SPSCByteStream: push() should signal the armed reader event" );
+  }
+  stream.arm_reader_event();
+  if ( not signalled( stream.reader_event() ) ) {
+    throw runtime_error( "SPSCByteStream: arming with bytes buffered should signal the reader event at once" );
+  }
+
+  stream.arm_writer_event();
+  if ( signalled( stream.writer_event() ) ) {
+    throw runtime_error( "SPSCByteStream: writer event signalled with no capacity" );
+  }
+  stream.pop( 1 );
+  if ( not signalled( stream.writer_event() ) ) {
+    throw runtime_error( "SPSCByteStream: pop() should signal the armed writer event" );
+  }
+
+  stream.pop( 3 );
+  stream.arm_reader_event();
+  if ( signalled( stream.reader_event() ) ) {
+    throw runtime_error( "SPSCByteStream: arming should clear the reader event" );
+  }
+  stream.close();
+  if ( not signalled( stream.reader_event() ) ) {
+    throw runtime_error( "SPSCByteStream: close() should signal the armed reader event" );
+  }
+}
+
+int main()
+{
+  try {
+    single_thread_test();
+    event_test();
+    two_thread_test( 1000, 1, 101 );
+    two_thread_test( 100000, 17, 202 );
+    two_thread_test( 1000000, 4096, 303 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,13 +1,19 @@
 #include "byte_stream_test_harness.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <stdexcept>
+#include <string>
 
 using namespace std;
 
-void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
-                  const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
-                  const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+void stress_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                  const ByteStream::Storage storage,
+                  const shared_ptr<BufferPool>& pool = {} )
 {
   default_random_engine rd { random_seed };
 
@@ -20,9 +26,10 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
     return ret;
   }();
 
-  ByteStreamTestHarness bs { "stress test input=" + to_string( input_len ) + ", capacity=" + to_string( capacity ),
-                             capacity };
-  if ( bs.skipped() ) {
+  const string test_name = "stress test input=" + to_string( input_len ) + ", capacity=" + to_string( capacity );
+  auto bs = pool ? make_unique<ByteStreamTestHarness>( test_name, capacity, pool )
+                 : make_unique<ByteStreamTestHarness>( test_name, capacity, storage );
+  if ( bs->skipped() ) {
     return;
   }
 
@@ -30,27 +37,31 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
   size_t expected_bytes_popped {};
   size_t expected_available_capacity { capacity };
   while ( expected_bytes_pushed < data.size() or expected_bytes_popped < data.size() ) {
-    bs.execute( BytesPushed { expected_bytes_pushed } );
-    bs.execute( BytesPopped { expected_bytes_popped } );
-    bs.execute( AvailableCapacity { expected_available_capacity } );
-    bs.execute( BytesBuffered { expected_bytes_pushed - expected_bytes_popped } );
+    bs->execute( BytesPushed { expected_bytes_pushed } );
+    bs->execute( BytesPopped { expected_bytes_popped } );
+    bs->execute( AvailableCapacity { expected_available_capacity } );
+    bs->execute( BytesBuffered { expected_bytes_pushed - expected_bytes_popped } );
 
     /* write something */
     uniform_int_distribution<size_t> bytes_to_push_dist { 0, data.size() - expected_bytes_pushed };
     const size_t amount_to_push = bytes_to_push_dist( rd );
-    bs.execute( Push { data.substr( expected_bytes_pushed, amount_to_push ) } );
+    if ( amount_to_push % 2 ) {
+      bs->execute( PushInPlace { data.substr( expected_bytes_pushed, amount_to_push ) } );
+    } else {
+      bs->execute( Push { data.substr( expected_bytes_pushed, amount_to_push ) } );
+    }
     expected_bytes_pushed += min( amount_to_push, expected_available_capacity );
     expected_available_capacity -= min( amount_to_push, expected_available_capacity );
 
-    bs.execute( BytesPushed { expected_bytes_pushed } );
-    bs.execute( AvailableCapacity { expected_available_capacity } );
+    bs->execute( BytesPushed { expected_bytes_pushed } );
+    bs->execute( AvailableCapacity { expected_available_capacity } );
 
     if ( expected_bytes_pushed == data.size() ) {
-      bs.execute( Close {} );
+      bs->execute( Close {} );
     }
 
     /* read something */
-    const size_t peek_size = bs.peek_size();
+    const size_t peek_size = bs->peek_size();
     if ( ( expected_bytes_pushed != expected_bytes_popped ) and peek_size == 0 ) {
       throw runtime_error( "ByteStream::reader().peek() returned empty view" );
     }
@@ -58,27 +69,107 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
       throw runtime_error( "ByteStream::reader().peek() returned too-large view" );
     }
 
-    bs.execute( PeekOnce { data.substr( expected_bytes_popped, peek_size ) } );
+    bs->execute( PeekOnce { data.substr( expected_bytes_popped, peek_size ) } );
+    bs->execute( PeekAll { data.substr( expected_bytes_popped, expected_bytes_pushed - expected_bytes_popped ) } );
 
     uniform_int_distribution<size_t> bytes_to_pop_dist { 0, peek_size };
     const size_t amount_to_pop = bytes_to_pop_dist( rd );
 
-    bs.execute( Pop { amount_to_pop } );
+    bs->execute( Pop { amount_to_pop } );
     expected_bytes_popped += amount_to_pop;
     expected_available_capacity += amount_to_pop;
-    bs.execute( BytesPopped { expected_bytes_popped } );
+    bs->execute( BytesPopped { expected_bytes_popped } );
+  }
+
+  bs->execute( IsClosed { true } );
+  bs->execute( IsFinished { true } );
+
+  if ( pool and pool->pages_in_use() != 0 ) {
+    throw runtime_error( "finished ByteStream did not return its pages to the BufferPool" );
+  }
+}
+
+// A paged stream keeps only the pages holding buffered bytes, however much was reserved
+void paged_reservation_test()
+{
+  const auto pool = make_shared<BufferPool>( 4096 );
+  ByteStream stream { 64000, pool };
+  const auto expect_pages = [&]( size_t pages, const string& after ) {
+    if ( pool->pages_in_use() != pages ) {
+      throw runtime_error( "paged ByteStream holds " + to_string( pool->pages_in_use() ) + " pages after " + after
+                           + " (expected " + to_string( pages ) + ")" );
+    }
+  };
+
+  stream.writer().reserve( 64000 );
+  expect_pages( 16, "reserve(64000)" );
+  stream.writer().commit( 100 );
+  expect_pages( 1, "commit(100)" );
+  stream.reader().pop( 100 );
+  expect_pages( 0, "popping everything" );
+
+  stream.writer().reserve( 64000 );
+  stream.writer().commit( 0 );
+  expect_pages( 0, "commit(0) on an empty stream" );
+
+  stream.writer().push( string( 5000, 'x' ) );
+  stream.writer().reserve( 64000 );
+  stream.writer().commit( 0 );
+  expect_pages( 2, "commit(0) with 5000 bytes buffered" );
+  stream.writer().reserve( 64000 );
+  stream.writer().push( "y" );
+  expect_pages( 2, "push() abandoning a reservation" );
+}
+
+// Committing a little of a large reservation, many times over, leaves a chunked stream holding just those bytes
+void chunked_reservation_test()
+{
+  ByteStream stream { 64000, ByteStream::Storage::Chunked };
+  const auto expect_buffered = [&]( uint64_t expected, const string& after ) {
+    if ( stream.reader().bytes_buffered() != expected
+         or stream.writer().available_capacity() != stream.capacity() - expected ) {
+      throw runtime_error( "chunked ByteStream has " + to_string( stream.reader().bytes_buffered() )
+                           + " bytes buffered after " + after + " (expected " + to_string( expected ) + ")" );
+    }
+  };
+
+  for ( int i = 0; i < 500; ++i ) {
+    const auto spans = stream.writer().reserve( stream.writer().available_capacity() );
+    fill_n( spans.front().data(), 10, 'x' );
+    stream.writer().commit( 10 );
   }
+  expect_buffered( 5000, "500 commits of 10 bytes into 64000-byte reservations" );
+
+  stream.writer().reserve( 64000 );
+  stream.writer().commit( 0 );
+  expect_buffered( 5000, "commit(0)" );
 
-  bs.execute( IsClosed { true } );
-  bs.execute( IsFinished { true } );
+  string out;
+  read( stream.reader(), UINT64_MAX, out );
+  if ( out != string( 5000, 'x' ) ) {
+    throw runtime_error( "chunked ByteStream did not return the committed bytes" );
+  }
 }
 
 void program_body()
 {
-  stress_test( 19, 3, 10110 );
-  stress_test( 18, 17, 12345 );
-  stress_test( 1111, 17, 98765 );
-  stress_test( 4097, 4096, 11101 );
+  for ( const auto storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+    stress_test( 19, 3, 10110, storage );
+    stress_test( 18, 17, 12345, storage );
+    stress_test( 1111, 17, 98765, storage );
+    stress_test( 4097, 4096, 11101, storage );
+  }
+
+  for ( const size_t page_size : { 5, 4096 } ) {
+    const auto pool = make_shared<BufferPool>( page_size );
+    stress_test( 19, 3, 10110, ByteStream::Storage::Paged, pool );
+    stress_test( 18, 17, 12345, ByteStream::Storage::Paged, pool );
+    stress_test( 1111, 17, 98765, ByteStream::Storage::Paged, pool );
+    stress_test( 4097, 4096, 11101, ByteStream::Storage::Paged, pool );
+  }
+
+  paged_reservation_test();
+  chunked_reservation_test();
 }
 
 int main()
@@ -4,6 +4,7 @@
 #include "common.hh"
 #include "helpers.hh"
 
+#include <memory>
 #include <utility>
 
 static_assert( sizeof( Reader ) == sizeof( ByteStream ),
@@ -15,10 +16,34 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name,
+                         uint64_t capacity,
+                         ByteStream::Storage storage = ByteStream::Storage::Ring )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + storage_description( storage ),
+                   ByteStream { capacity, storage } )
   {}
 
+  ByteStreamTestHarness( std::string test_name, uint64_t capacity, std::shared_ptr<BufferPool> pool )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + storage_description( ByteStream::Storage::Paged )
+                     + ", page_size=" + std::to_string( pool->page_size() ),
+                   ByteStream { capacity, pool } )
+  {}
+
+  static std::string storage_description( ByteStream::Storage storage )
+  {
+    switch ( storage ) {
+      case ByteStream::Storage::Ring:
+        return "";
+      case ByteStream::Storage::Chunked:
+        return ", storage=chunked";
+      case ByteStream::Storage::Paged:
+        return ", storage=paged";
+    }
+    return ", storage=unknown";
+  }
+
   size_t peek_size() { return object().reader().peek().size(); }
 };
 
@@ -34,6 +59,26 @@ struct Push : public Action<ByteStream>
   constexpr std::string obj() const override { return "Writer"; }
 };
 
+struct PushInPlace : public Push
+{
+  using Push::Push;
+
+  std::string description() const override
+  {
+    return "reserve + commit \"" + pretty_print( data_ ) + "\" in the stream";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    uint64_t written = 0;
+    for ( const auto span : bs.writer().reserve( data_.size() ) ) {
+      data_.copy( span.data(), span.size(), written );
+      written += span.size();
+    }
+    bs.writer().commit( written );
+  }
+};
+
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
@@ -57,6 +102,33 @@ struct Pop : public Action<ByteStream>
   constexpr std::string obj() const override { return "Reader"; }
 };
 
+struct Crossings
+{
+  unsigned low {};
+  unsigned high {};
+};
+
+struct SetWatermarks : public Action<ByteStream>
+{
+  uint64_t low_;
+  uint64_t high_;
+  std::shared_ptr<Crossings> crossings_;
+
+  SetWatermarks( uint64_t low, uint64_t high, std::shared_ptr<Crossings> crossings ) // NOLINT(*-swappable-*)
+    : low_( low ), high_( high ), crossings_( std::move( crossings ) )
+  {}
+
+  std::string description() const override
+  {
+    return "set watermarks low=" + std::to_string( low_ ) + ", high=" + std::to_string( high_ );
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    bs.set_watermarks( low_, high_, [c = crossings_] { ++c->low; }, [c = crossings_] { ++c->high; } );
+  }
+};
+
 /* expectations */
 
 struct Peek : public Expectation<ByteStream>
@@ -119,6 +191,55 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekAll : public Peek
+{
+  using Peek::Peek;
+
+  std::string description() const override
+  {
+    return "peek_all() gives pieces adding up to \"" + pretty_print( output_ ) + "\"";
+  }
+
+  void execute( const ByteStream& bs ) const override
+  {
+    std::string got;
+    for ( const auto piece : bs.reader().peek_all() ) {
+      if ( piece.empty() ) {
+        throw ExpectationViolation { "peek_all() returned an empty piece" };
+      }
+      got += piece;
+    }
+    if ( got != output_ ) {
+      throw ExpectationViolation { "peek_all() should have returned \"" + pretty_print( output_ )
+                                   + "\", but instead returned \"" + pretty_print( got ) + "\"" };
+    }
+  }
+};
+
+struct WatermarkCrossings : public Expectation<ByteStream>
+{
+  std::shared_ptr<Crossings> crossings_;
+  Crossings expected_;
+
+  WatermarkCrossings( std::shared_ptr<Crossings> crossings, unsigned low, unsigned high ) // NOLINT(*-swappable-*)
+    : crossings_( std::move( crossings ) ), expected_( low, high )
+  {}
+
+  std::string description() const override
+  {
+    return "low watermark crossed " + std::to_string( expected_.low ) + " time(s), high watermark crossed "
+           + std::to_string( expected_.high ) + " time(s)";
+  }
+
+  void execute( const ByteStream& /* unused */ ) const override
+  {
+    if ( crossings_->low != expected_.low or crossings_->high != expected_.high ) {
+      throw ExpectationViolation { "watermarks were crossed " + std::to_string( crossings_->low ) + " (low) and "
+                                   + std::to_string( crossings_->high ) + " (high) time(s)" };
+    }
+  }
+};
+
 struct IsClosed : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
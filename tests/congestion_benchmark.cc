@@ -0,0 +1,223 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Congestion control benchmark: an in-process bulk transfer over an emulated path.
+ *
+ * A TCPSender with an endless stream to send talks to a TCPReceiver through a bottleneck link
+ * (a fixed rate, a drop-tail queue, optionally random loss, and 50 ms of delay each way, so a
+ * 100 ms RTT); the receiver acknowledges every segment, and its application reads everything at
+ * once. Time advances in 1 ms ticks. For each path and each congestion control algorithm, unpaced
+ * and paced, recovering losses by timeout only or by fast retransmit too, one row is printed as CSV
+ * (default) or JSON (--json): the goodput, the share of the bottleneck's rate it used, segments
+ * retransmitted and dropped, the mean sequence numbers in flight, and the mean time segments spent
+ * queued at the bottleneck.
+ *
+ * The receiver's window can't exceed 65,535 bytes (there is no window scaling), which caps any
+ * flow at about 5.2 Mbit/s at this RTT: the paths are kept below that so the congestion window,
+ * not the receiver's, is what limits the sender.
+ */
+
+namespace {
+
+constexpr uint64_t one_way_delay_ms = 50;
+constexpr uint64_t duration_ms = 60'000;
+constexpr uint64_t header_bytes = 40; // Counted against the bottleneck's rate and queue, as IP and TCP headers
+constexpr uint64_t pacing_burst = 2;
+
+struct Path
+{
+  string name;
+  double mbit_per_s;
+  uint64_t queue_bytes;
+  double loss_rate;
+};
+
+struct Result
+{
+  uint64_t bytes_delivered;
+  uint64_t retransmissions;
+  uint64_t drops;
+  double mean_in_flight;
+  double mean_queue_ms;
+};
+
+template<typename Message>
+struct Arrival
+{
+  double at_ms;
+  Message message;
+};
+
+Result run( const Path& path, CongestionControl::Algorithm algorithm, bool pacing, bool fast_retransmit )
+{
+  default_random_engine rd { 16180 };
+  bernoulli_distribution lost { path.loss_rate };
+  const Wrap32 isn { 0xfffff000 };
+  const double bytes_per_ms = path.mbit_per_s * 1e6 / 8 / 1000;
+
+  TCPSender sender { ByteStream { 1 << 16 },
+                     isn,
+                     TCPConfig::TIMEOUT_DFLT,
+                     CongestionControl::make( algorithm, TCPConfig::MAX_PAYLOAD_SIZE ) };
+  if ( pacing ) {
+    sender.set_pacing( pacing_burst );
+  }
+  sender.set_fast_retransmit( fast_retransmit );
+  TCPReceiver receiver { Reassembler { ByteStream { 1 << 16 } } };
+
+  deque<Arrival<TCPSenderMessage>> forward;
+  deque<Arrival<TCPReceiverMessage>> reverse;
+  Result result {};
+  uint64_t now_ms = 0;
+  double link_free_ms = 0; // When the bottleneck finishes sending what it has queued
+  uint64_t highest_sent = 0;
+  uint64_t segments_queued = 0;
+  double queue_ms = 0;
+
+  const auto transmit = [&]( const TCPSenderMessage& message ) {
+    const uint64_t seqno = message.seqno.unwrap( isn, highest_sent );
+    if ( seqno < highest_sent ) {
+      ++result.retransmissions;
+    }
+    highest_sent = max( highest_sent, seqno + message.sequence_length() );
+
+    const double waiting_ms = max( 0.0, link_free_ms - static_cast<double>( now_ms ) );
+    const auto bytes = static_cast<double>( message.sequence_length() + header_bytes );
+    if ( lost( rd ) or waiting_ms * bytes_per_ms + bytes > static_cast<double>( path.queue_bytes ) ) {
+      ++result.drops;
+      return;
+    }
+    link_free_ms = static_cast<double>( now_ms ) + waiting_ms + bytes / bytes_per_ms;
+    forward.push_back( { link_free_ms + one_way_delay_ms, message } );
+    ++segments_queued;
+    queue_ms += waiting_ms;
+  };
+
+  const string chunk( 1 << 16, 'x' );
+  double in_flight_sum = 0;
+  for ( now_ms = 1; now_ms <= duration_ms; ++now_ms ) {
+    const auto now = static_cast<double>( now_ms );
+    while ( !forward.empty() and forward.front().at_ms <= now ) {
+      receiver.receive( move( forward.front().message ) );
+      forward.pop_front();
+      result.bytes_delivered += receiver.reader().bytes_buffered();
+      receiver.reader().pop( receiver.reader().bytes_buffered() );
+      reverse.push_back( { now + one_way_delay_ms, receiver.send() } );
+    }
+    while ( !reverse.empty() and reverse.front().at_ms <= now ) {
+      sender.receive( reverse.front().message );
+      reverse.pop_front();
+    }
+
+    sender.tick( 1, transmit );
+    sender.writer().push( chunk.substr( 0, sender.writer().available_capacity() ) );
+    sender.push( transmit );
+    in_flight_sum += static_cast<double>( sender.sequence_numbers_in_flight() );
+  }
+
+  result.mean_in_flight = in_flight_sum / duration_ms;
+  result.mean_queue_ms = segments_queued ? queue_ms / static_cast<double>( segments_queued ) : 0;
+  return result;
+}
+
+string_view algorithm_name( CongestionControl::Algorithm algorithm )
+{
+  switch ( algorithm ) {
+    case CongestionControl::Algorithm::None:
+      return "none";
+    case CongestionControl::Algorithm::NewReno:
+      return "newreno";
+    case CongestionControl::Algorithm::Cubic:
+      return "cubic";
+  }
+  return "unknown";
+}
+
+void program_body( bool json )
+{
+  const vector<Path> paths {
+    { "2mbit_shallow_queue", 2, 10'000, 0 },
+    { "4mbit_shallow_queue", 4, 10'000, 0 },
+    { "4mbit_deep_queue", 4, 50'000, 0 },
+    { "4mbit_random_loss", 4, 50'000, 0.0005 },
+  };
+
+  if ( json ) {
+    cout << "[\n";
+  } else {
+    cout << "path,algorithm,pacing,recovery,seconds,goodput_mbit_per_s,utilization,retransmissions,drops,"
+            "mean_in_flight,mean_queue_ms\n";
+  }
+
+  bool first = true;
+  for ( const auto& path : paths ) {
+    for ( const auto algorithm : { CongestionControl::Algorithm::None,
+                                   CongestionControl::Algorithm::NewReno,
+                                   CongestionControl::Algorithm::Cubic } ) {
+      for ( const bool pacing : { false, true } ) {
+        for ( const bool fast_retransmit : { false, true } ) {
+          const Result r = run( path, algorithm, pacing, fast_retransmit );
+          const double seconds = duration_ms / 1000.0;
+          const double goodput = 8.0 * static_cast<double>( r.bytes_delivered ) / seconds / 1e6;
+          const double utilization = goodput / path.mbit_per_s;
+          const string_view recovery = fast_retransmit ? "fast_retransmit" : "timeout";
+
+          ostringstream row;
+          row << fixed << setprecision( 3 );
+          if ( json ) {
+            row << ( first ? "  " : ", " ) << "{\"path\": \"" << path.name << "\", \"algorithm\": \""
+                << algorithm_name( algorithm ) << "\", \"pacing\": " << ( pacing ? "true" : "false" )
+                << ", \"recovery\": \"" << recovery << "\", \"seconds\": " << seconds
+                << ", \"goodput_mbit_per_s\": " << goodput << ", \"utilization\": " << utilization
+                << ", \"retransmissions\": " << r.retransmissions << ", \"drops\": " << r.drops
+                << ", \"mean_in_flight\": " << r.mean_in_flight << ", \"mean_queue_ms\": " << r.mean_queue_ms
+                << "}\n";
+          } else {
+            row << path.name << "," << algorithm_name( algorithm ) << "," << ( pacing ? "paced" : "unpaced" )
+                << "," << recovery << "," << seconds << "," << goodput << "," << utilization << ","
+                << r.retransmissions << "," << r.drops << "," << r.mean_in_flight << "," << r.mean_queue_ms
+                << "\n";
+          }
+          cout << row.str() << flush;
+          first = false;
+        }
+      }
+    }
+  }
+
+  if ( json ) {
+    cout << "]\n";
+  }
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    const bool json = argc > 1 and string_view { argv[1] } == "--json"; // NOLINT(*-pointer-arithmetic)
+    program_body( json );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
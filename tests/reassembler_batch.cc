@@ -0,0 +1,180 @@
+#include "byte_stream_test_harness.hh"
+#include "random.hh"
+#include "reassembler_test_harness.hh"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+bool operator==( const Reassembler::Stats& a, const Reassembler::Stats& b )
+{
+  return a.holes == b.holes and a.max_out_of_order_distance == b.max_out_of_order_distance
+         and a.bytes_discarded == b.bytes_discarded and a.duplicate_bytes == b.duplicate_bytes
+         and a.merges == b.merges and a.prunes == b.prunes and a.bytes_pruned == b.bytes_pruned;
+}
+
+} // namespace
+
+// Batches of random segments must leave the Reassembler exactly as inserting them one at a time would, and
+// count what inserting them one at a time in order of first index would
+void random_batches( const Reassembler::Storage storage, default_random_engine& rd )
+{
+  const size_t capacity = 1000;
+  const size_t input_len = 20000;
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  Reassembler one_at_a_time { ByteStream { capacity }, storage };
+  Reassembler index_order { ByteStream { capacity }, storage };
+  Reassembler batched { ByteStream { capacity }, storage };
+  string one_at_a_time_output;
+  string batched_output;
+
+  uniform_int_distribution<size_t> batch_size { 0, 16 };
+  uniform_int_distribution<size_t> segment_len { 0, 200 };
+  while ( not one_at_a_time.reader().is_finished() ) {
+    const uint64_t next = one_at_a_time.writer().bytes_pushed();
+    uniform_int_distribution<uint64_t> first_index { next > 100 ? next - 100 : 0, next + capacity };
+    vector<Reassembler::Substring> batch;
+    for ( size_t i = batch_size( rd ); i > 0; --i ) {
+      const uint64_t index = min( static_cast<uint64_t>( data.size() ), first_index( rd ) );
+      const string segment = data.substr( index, segment_len( rd ) );
+      one_at_a_time.insert( index, segment, index + segment.size() == data.size() );
+      batch.push_back( { index, segment, index + segment.size() == data.size() } );
+    }
+    vector<Reassembler::Substring> sorted = batch;
+    ranges::stable_sort( sorted, {}, &Reassembler::Substring::first_index );
+    for ( const auto& [index, segment, is_last] : sorted ) {
+      index_order.insert( index, segment, is_last );
+    }
+    batched.insert_many( batch );
+
+    if ( batched.writer().bytes_pushed() != one_at_a_time.writer().bytes_pushed()
+         or batched.count_bytes_pending() != one_at_a_time.count_bytes_pending()
+         or batched.writer().is_closed() != one_at_a_time.writer().is_closed()
+         or batched.stats().duplicate_bytes != one_at_a_time.stats().duplicate_bytes
+         or batched.stats().bytes_discarded != one_at_a_time.stats().bytes_discarded
+         or not( batched.stats() == index_order.stats() ) ) {
+      throw runtime_error( "insert_many() disagrees with insert() (storage "
+                           + to_string( static_cast<int>( storage ) ) + ")" );
+    }
+
+    string chunk;
+    read( one_at_a_time.reader(), capacity, chunk );
+    one_at_a_time_output += chunk;
+    read( batched.reader(), capacity, chunk );
+    batched_output += chunk;
+    read( index_order.reader(), capacity, chunk );
+  }
+
+  if ( one_at_a_time_output != data or batched_output != data or not batched.reader().is_finished() ) {
+    throw runtime_error( "insert_many() did not reassemble the stream" );
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      ReassemblerTestHarness test { "batch in order", 65000 };
+
+      test.execute( InsertMany {}.insert( "abcd", 0 ).insert( "efgh", 4 ).insert( "ijkl", 8 ) );
+      test.execute( BytesPushed( 12 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefghijkl" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "batch out of order with overlap", 65000 };
+
+      test.execute( InsertMany {}.insert( "ijkl", 8 ).insert( "cdefgh", 2 ).insert( "abcd", 0 ).insert( "gh", 6 ) );
+      test.execute( BytesPushed( 12 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefghijkl" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "batch with duplicates", 65000 };
+
+      test.execute( InsertMany {}.insert( "fgh", 5 ).insert( "fgh", 5 ).insert( "gh", 6 ) );
+      test.execute( BytesPending( 3 ) );
+      test.execute( DuplicateBytes( 5 ) );
+      test.execute( Merges( 2 ) );
+      test.execute( Holes( 1 ) );
+      test.execute( MaxOutOfOrderDistance( 6 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "batch with a hole", 65000 };
+
+      test.execute( InsertMany {}.insert( "efgh", 4 ).insert( "mnop", 12 ).insert( "ab", 0 ) );
+      test.execute( BytesPushed( 2 ) );
+      test.execute( BytesPending( 8 ) );
+      test.execute( InsertMany {}.insert( "ijkl", 8 ).insert( "cd", 2 ) );
+      test.execute( BytesPushed( 16 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefghijklmnop" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "batch with the last substring first", 65000 };
+
+      test.execute( InsertMany {}.insert( "ef", 4, true ).insert( "abcd", 0 ) );
+      test.execute( BytesPushed( 6 ) );
+      test.execute( IsFinished( false ) );
+      test.execute( ReadAll( "abcdef" ) );
+      test.execute( IsFinished( true ) );
+    }
+
+    for ( const auto storage : { Reassembler::Storage::Map,
+                                 Reassembler::Storage::Ring,
+                                 Reassembler::Storage::Flat,
+                                 Reassembler::Storage::Slices } ) {
+      ReassemblerTestHarness test { "batch of duplicates with an empty last substring", 65000, storage };
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( IsClosed( false ) );
+      test.execute( InsertMany {}.insert( "ab", 0 ).insert( "", 2, true ) );
+      test.execute( BytesPushed( 2 ) );
+      test.execute( IsClosed( true ) );
+      test.execute( ReadAll( "ab" ) );
+      test.execute( IsFinished( true ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "batch beyond capacity", 8 };
+
+      test.execute( InsertMany {}.insert( "efghij", 4 ).insert( "abcd", 0 ) );
+      test.execute( BytesPushed( 8 ) );
+      test.execute( ReadAll( "abcdefgh" ) );
+      test.execute( InsertMany {}.insert( "ij", 8, true ) );
+      test.execute( ReadAll( "ij" ) );
+      test.execute( IsFinished( true ) );
+    }
+
+    for ( const auto storage : { Reassembler::Storage::Map,
+                                 Reassembler::Storage::Ring,
+                                 Reassembler::Storage::Flat,
+                                 Reassembler::Storage::Slices } ) {
+      random_batches( storage, rd );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
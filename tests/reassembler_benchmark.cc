@@ -0,0 +1,233 @@
+#include "allocation_counter.hh"
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * Reassembler benchmark: pathological delivery orders.
+ *
+ * Each scenario cuts a random stream into segments and delivers them in an adversarial order
+ * (reversed, permuted, overlapping and duplicated, one byte at a time, with one hole filled last,
+ * or overrunning the capacity so bytes are discarded and must be sent again), to each Reassembler
+ * storage backend in turn. One row per case is printed as CSV (default) or JSON (--json), with the
+ * throughput, the cost per segment and the heap allocations per MB delivered.
+ */
+
+namespace {
+
+constexpr uint64_t capacity = 65536;
+constexpr uint64_t segment_size = 1460;
+
+struct Segment
+{
+  uint64_t first_index;
+  string data;
+  bool is_last;
+};
+
+// Segments are delivered a round at a time; the reader drains the stream after every segment,
+// or only at the end of each round (so a round can overrun the stream's capacity)
+struct Rounds
+{
+  vector<vector<Segment>> rounds {};
+  bool drain_per_segment { true };
+};
+
+struct Result
+{
+  double seconds;
+  uint64_t segments;
+  uint64_t allocations;
+};
+
+string make_data( uint64_t len, default_random_engine& rd )
+{
+  uniform_int_distribution<char> ud;
+  string ret;
+  ret.reserve( len );
+  for ( uint64_t i = 0; i < len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+// Cut [begin, end) of `data` into segments of `size` bytes, starting one every `stride` bytes
+vector<Segment> cut( const string& data, uint64_t begin, uint64_t end, uint64_t size, uint64_t stride )
+{
+  vector<Segment> segments;
+  for ( uint64_t i = begin; i < end; i += stride ) {
+    const uint64_t len = min( size, data.size() - i );
+    segments.push_back( { i, data.substr( i, len ), i + len == data.size() } );
+  }
+  return segments;
+}
+
+// One round per window of the stream, with each window's segments put in order by `arrange`
+Rounds per_window( const string& data,
+                   uint64_t size,
+                   uint64_t stride,
+                   const function<void( vector<Segment>& )>& arrange )
+{
+  Rounds r;
+  for ( uint64_t begin = 0; begin < data.size(); begin += capacity ) {
+    r.rounds.push_back( cut( data, begin, min( begin + capacity, data.size() ), size, stride ) );
+    arrange( r.rounds.back() );
+  }
+  return r;
+}
+
+Result run( Reassembler::Storage storage, const string& data, Rounds r, string& output_data )
+{
+  Reassembler reassembler { ByteStream { capacity }, storage };
+  output_data.clear();
+  uint64_t segments = 0;
+
+  const auto drain = [&] {
+    while ( reassembler.reader().bytes_buffered() ) {
+      const auto peeked = reassembler.reader().peek();
+      output_data += peeked;
+      reassembler.reader().pop( peeked.size() );
+    }
+  };
+
+  const uint64_t allocations_before = allocations.load();
+  const auto start_time = steady_clock::now();
+  for ( auto& round : r.rounds ) {
+    for ( auto& segment : round ) {
+      reassembler.insert( segment.first_index, move( segment.data ), segment.is_last );
+      ++segments;
+      if ( r.drain_per_segment ) {
+        drain();
+      }
+    }
+    drain();
+  }
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations_after = allocations.load();
+
+  if ( not reassembler.reader().is_finished() or data != output_data ) {
+    throw runtime_error( "Reassembler did not reassemble the stream" );
+  }
+
+  return { duration_cast<duration<double>>( stop_time - start_time ).count(),
+           segments,
+           allocations_after - allocations_before };
+}
+
+void program_body( bool json )
+{
+  default_random_engine rd { 2718 };
+  const string data = make_data( uint64_t { 1 } << 23, rd );
+  const string tiny_data = make_data( uint64_t { 1 } << 19, rd );
+
+  // One output buffer for every case, already paged in, so no case pays to fault it in
+  string output_data( data.size(), 0 );
+
+  const auto shuffled = [&]( vector<Segment>& segments ) { shuffle( segments.begin(), segments.end(), rd ); };
+
+  // Every round offers the two windows ahead of the reader, in random order; the second is discarded
+  const auto overrun = [&] {
+    Rounds r { {}, false };
+    for ( uint64_t begin = 0; begin < data.size(); begin += capacity ) {
+      const uint64_t end = min( begin + 2 * capacity, data.size() );
+      r.rounds.push_back( cut( data, begin, end, segment_size, segment_size ) );
+      shuffle( r.rounds.back().begin(), r.rounds.back().end(), rd );
+    }
+    return r;
+  };
+
+  const vector<pair<string, function<Rounds()>>> scenarios {
+    { "in_order", [&] { return per_window( data, segment_size, segment_size, []( auto& ) {} ); } },
+    { "reversed",
+      [&] {
+        return per_window(
+          data, segment_size, segment_size, []( auto& segments ) { ranges::reverse( segments ); } );
+      } },
+    { "random_permutation", [&] { return per_window( data, segment_size, segment_size, shuffled ); } },
+    { "overlap_and_duplicates",
+      [&] {
+        return per_window( data, segment_size, segment_size / 4, [&]( auto& segments ) {
+          const auto copies = segments;
+          segments.insert( segments.end(), copies.begin(), copies.end() );
+          shuffled( segments );
+        } );
+      } },
+    { "one_byte_segments", [&] { return per_window( tiny_data, 1, 1, shuffled ); } },
+    { "large_hole_filled_last",
+      [&] {
+        return per_window( data, segment_size, segment_size, []( auto& segments ) {
+          ranges::rotate( segments, segments.begin() + 1 );
+        } );
+      } },
+    { "capacity_overrun", overrun },
+  };
+
+  if ( json ) {
+    cout << "[\n";
+  } else {
+    cout << "scenario,storage,bytes,segments,gbit_per_s,ns_per_segment,allocs_per_mb\n";
+  }
+
+  bool first = true;
+  for ( const auto& [name, make_rounds] : scenarios ) {
+    for ( const auto storage : { Reassembler::Storage::Map,
+                                 Reassembler::Storage::Ring,
+                                 Reassembler::Storage::Flat,
+                                 Reassembler::Storage::Slices } ) {
+      const string& input = name == "one_byte_segments" ? tiny_data : data;
+      const Result r = run( storage, input, make_rounds(), output_data );
+
+      const auto bytes = static_cast<double>( input.size() );
+      const double gigabits_per_second = 8.0 * bytes / r.seconds / 1e9;
+      const double ns_per_segment = r.seconds * 1e9 / static_cast<double>( r.segments );
+      const double allocations_per_mb = static_cast<double>( r.allocations ) / ( bytes / 1e6 );
+
+      ostringstream row;
+      row << fixed << setprecision( 3 );
+      if ( json ) {
+        row << ( first ? "  " : ", " ) << "{\"scenario\": \"" << name << "\", \"storage\": \""
+            << Reassembler::storage_name( storage ) << "\", \"bytes\": " << input.size()
+            << ", \"segments\": " << r.segments << ", \"gbit_per_s\": " << gigabits_per_second
+            << ", \"ns_per_segment\": " << ns_per_segment << ", \"allocs_per_mb\": " << allocations_per_mb << "}\n";
+      } else {
+        row << name << "," << Reassembler::storage_name( storage ) << "," << input.size() << "," << r.segments
+            << "," << gigabits_per_second << "," << ns_per_segment << "," << allocations_per_mb << "\n";
+      }
+      cout << row.str() << flush;
+      first = false;
+    }
+  }
+
+  if ( json ) {
+    cout << "]\n";
+  }
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    const bool json = argc > 1 and string_view { argv[1] } == "--json"; // NOLINT(*-pointer-arithmetic)
+    program_body( json );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include "byte_stream_test_harness.hh"
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    for ( const auto storage : { Reassembler::Storage::Map,
+                                 Reassembler::Storage::Ring,
+                                 Reassembler::Storage::Flat,
+                                 Reassembler::Storage::Slices } ) {
+      {
+        ReassemblerTestHarness test { "byte limit drops the farthest bytes", 32, storage };
+
+        test.execute( SetPendingLimits { 6, UINT64_MAX } );
+        test.execute( Insert { "cd", 2 } );
+        test.execute( Insert { "ghij", 6 } );
+        test.execute( BytesPending { 6 } );
+        test.execute( Prunes { 0 } );
+        test.execute( Insert { "mn", 12 } );
+        test.execute( BytesPending { 6 } );
+        test.execute( Prunes { 1 } );
+        test.execute( BytesPruned { 2 } );
+        test.execute( ReceivedBlocks { { { 2, 4 }, { 6, 10 } } } );
+        test.execute( Insert { "ef", 4 } );
+        test.execute( BytesPending { 6 } );
+        test.execute( BytesPruned { 4 } );
+        test.execute( ReceivedBlocks { { { 2, 8 } } } );
+        test.execute( Insert { "ab", 0 } );
+        test.execute( BytesPushed { 8 } );
+        test.execute( BytesPending { 0 } );
+        test.execute( Insert { "ijklmn", 8 } );
+        test.execute( BytesPushed { 14 } );
+        test.execute( ReadAll( "abcdefghijklmn" ) );
+        test.execute( Prunes { 2 } );
+      }
+
+      {
+        ReassemblerTestHarness test { "run limit drops the farthest runs", 32, storage };
+
+        test.execute( SetPendingLimits { UINT64_MAX, 2 } );
+        test.execute( Insert { "b", 1 } );
+        test.execute( Insert { "d", 3 } );
+        test.execute( Insert { "f", 5 } );
+        test.execute( Holes { 2 } );
+        test.execute( BytesPending { 2 } );
+        test.execute( ReceivedBlocks { { { 1, 2 }, { 3, 4 } } } );
+        test.execute( Insert { "hij", 7 } );
+        test.execute( ReceivedBlocks { { { 1, 2 }, { 3, 4 } } } );
+        test.execute( Insert { "c", 2 } );
+        test.execute( Insert { "hij", 7 } );
+        test.execute( ReceivedBlocks { { { 1, 4 }, { 7, 10 } } } );
+        test.execute( Prunes { 2 } );
+        test.execute( BytesPruned { 4 } );
+      }
+
+      {
+        ReassemblerTestHarness test { "tightening the limits prunes at once", 32, storage };
+
+        test.execute( Insert { "cd", 2 } );
+        test.execute( Insert { "ghij", 6 } );
+        test.execute( Insert { "mn", 12 } );
+        test.execute( BytesPending { 8 } );
+        test.execute( SetPendingLimits { 4, 1 } );
+        test.execute( ReceivedBlocks { { { 2, 4 } } } );
+        test.execute( BytesPending { 2 } );
+        test.execute( Prunes { 1 } );
+        test.execute( BytesPruned { 6 } );
+      }
+
+      {
+        ReassemblerTestHarness test { "pruning a run that wraps the window", 8, storage };
+
+        test.execute( SetPendingLimits { 3, UINT64_MAX } );
+        test.execute( Insert { "abcde", 0 } );
+        test.execute( ReadAll( "abcde" ) );
+        test.execute( Insert { "hijk", 7 } );
+        test.execute( BytesPending { 3 } );
+        test.execute( ReceivedBlocks { { { 7, 10 } } } );
+        test.execute( Insert { "fg", 5 } );
+        test.execute( ReadAll( "fghij" ) );
+        test.execute( BytesPruned { 1 } );
+      }
+
+      {
+        ReassemblerTestHarness test { "in-order bytes are never pruned", 32, storage };
+
+        test.execute( SetPendingLimits { 0, 0 } );
+        test.execute( Insert { "abcd", 0 } );
+        test.execute( Insert { "ghij", 6 } );
+        test.execute( BytesPending { 0 } );
+        test.execute( Insert { "ef", 4 } );
+        test.execute( ReadAll( "abcdef" ) );
+        test.execute( IsFinished { false } );
+        test.execute( Insert { "ghij", 6 }.is_last() );
+        test.execute( ReadAll( "ghij" ) );
+        test.execute( IsFinished { true } );
+        test.execute( BytesPruned { 4 } );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
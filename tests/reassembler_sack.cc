@@ -0,0 +1,55 @@
+#include "byte_stream_test_harness.hh"
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    for ( const auto storage : { Reassembler::Storage::Map,
+                                 Reassembler::Storage::Ring,
+                                 Reassembler::Storage::Flat,
+                                 Reassembler::Storage::Slices } ) {
+      {
+        ReassemblerTestHarness test { "received blocks", 16, storage };
+
+        test.execute( ReceivedBlocks { {} } );
+        test.execute( Insert { "c", 2 } );
+        test.execute( ReceivedBlocks { { { 2, 3 } } } );
+        test.execute( Insert { "gh", 6 } );
+        test.execute( Insert { "k", 10 } );
+        test.execute( Insert { "o", 14 } );
+        test.execute( ReceivedBlocks { { { 2, 3 }, { 6, 8 }, { 10, 11 }, { 14, 15 } } } );
+        test.execute( ReceivedBlocks { { { 2, 3 }, { 6, 8 } }, 2 } );
+        test.execute( Insert { "def", 3 } );
+        test.execute( ReceivedBlocks { { { 2, 8 }, { 10, 11 }, { 14, 15 } } } );
+        test.execute( Insert { "ab", 0 } );
+        test.execute( BytesPushed { 8 } );
+        test.execute( ReceivedBlocks { { { 10, 11 }, { 14, 15 } } } );
+        test.execute( ReadAll( "abcdefgh" ) );
+      }
+
+      {
+        ReassemblerTestHarness test { "received blocks across the end of the window", 8, storage };
+
+        test.execute( Insert { "abcde", 0 } );
+        test.execute( ReadAll( "abcde" ) );
+        test.execute( Insert { "hijk", 7 } );
+        test.execute( Insert { "m", 12 } );
+        test.execute( ReceivedBlocks { { { 7, 11 }, { 12, 13 } } } );
+        test.execute( Insert { "fg", 5 } );
+        test.execute( ReceivedBlocks { { { 12, 13 } } } );
+        test.execute( ReadAll( "fghijk" ) );
+        test.execute( ReceivedBlocks { { { 12, 13 } } } );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
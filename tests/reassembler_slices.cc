@@ -0,0 +1,91 @@
+#include "byte_stream_test_harness.hh"
+#include "reassembler.hh"
+
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "Slices storage: expected " + what );
+  }
+}
+
+shared_ptr<const string> buffer( string data )
+{
+  return make_shared<const string>( move( data ) );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    // Stored bytes are kept by reference, and the reference is dropped once they are written
+    {
+      Reassembler reassembler { ByteStream { 64 }, Reassembler::Storage::Slices };
+      const auto late = buffer( "efgh" );
+      reassembler.insert( 4, late, false );
+      expect( late.use_count() == 2, "the stored payload to be referenced, not copied" );
+      expect( reassembler.count_bytes_pending() == 4, "4 bytes pending" );
+      reassembler.insert( 0, buffer( "abcd" ), false );
+      expect( late.use_count() == 1, "the reference to be dropped once the bytes are written" );
+      string output;
+      read( reassembler.reader(), 8, output );
+      expect( output == "abcdefgh", "\"abcdefgh\", got \"" + output + "\"" );
+    }
+
+    // A payload that fills several holes is referenced once per hole
+    {
+      Reassembler reassembler { ByteStream { 64 }, Reassembler::Storage::Slices };
+      reassembler.insert( 3, buffer( "d" ), false );
+      reassembler.insert( 6, buffer( "g" ), false );
+      const auto filler = buffer( "bcdefghi" );
+      reassembler.insert( 1, filler, true );
+      expect( filler.use_count() == 4, "one reference per hole filled" );
+      expect( reassembler.count_bytes_pending() == 8, "8 bytes pending" );
+      expect( reassembler.stats().holes == 1, "the runs to be joined into one" );
+      reassembler.insert( 0, buffer( "a" ), false );
+      expect( filler.use_count() == 1, "every reference to be dropped once the bytes are written" );
+      string output;
+      read( reassembler.reader(), 9, output );
+      expect( output == "abcdefghi", "\"abcdefghi\", got \"" + output + "\"" );
+      expect( reassembler.reader().is_finished(), "the stream to be finished" );
+    }
+
+    // Pruning trims the farthest slice without copying the rest
+    {
+      Reassembler reassembler { ByteStream { 64 }, Reassembler::Storage::Slices };
+      reassembler.set_pending_limits( 3, UINT64_MAX );
+      const auto payload = buffer( "cdef" );
+      reassembler.insert( 2, payload, false );
+      expect( payload.use_count() == 2, "the trimmed payload to still be referenced" );
+      expect( reassembler.count_bytes_pending() == 3, "3 bytes pending" );
+      reassembler.insert( 0, buffer( "ab" ), false );
+      string output;
+      read( reassembler.reader(), 8, output );
+      expect( output == "abcde", "\"abcde\", got \"" + output + "\"" );
+    }
+
+    // Other storages copy what they keep
+    {
+      Reassembler reassembler { ByteStream { 64 }, Reassembler::Storage::Map };
+      const auto late = buffer( "efgh" );
+      reassembler.insert( 4, late, false );
+      expect( late.use_count() == 1, "map storage to keep its own copy" );
+      reassembler.insert( 0, buffer( "abcd" ), false );
+      expect( reassembler.writer().bytes_pushed() == 8, "8 bytes pushed" );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -17,6 +17,7 @@ void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-p
                  const size_t overlap,     // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const Reassembler::Storage storage,
                  string_view scenario )
 {
   // Generate the data to be written
@@ -46,7 +47,7 @@ void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-p
     }
   }
 
-  Reassembler reassembler { ByteStream { capacity } };
+  Reassembler reassembler { ByteStream { capacity }, storage };
 
   string output_data;
   output_data.reserve( data.size() );
@@ -81,10 +82,11 @@ void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-p
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  cout << "Reassembler (" << Reassembler::storage_name( storage ) << ") to ByteStream with capacity=" << capacity
+       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
 
-  debug_output << "        Reassembler throughput " << scenario << fixed << setprecision( 2 ) << setw( 5 )
+  debug_output << "        Reassembler throughput " << setw( 6 ) << left << Reassembler::storage_name( storage )
+               << right << " " << scenario << fixed << setprecision( 2 ) << setw( 5 )
                << gigabits_per_second << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
@@ -94,8 +96,13 @@ void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-p
 
 void program_body()
 {
-  speed_test( 1000, 1500, 1500, 32768, 1370, "(no overlap):  " );
-  speed_test( 1000, 1500, 150, 32768, 6163, "(10x overlap): " );
+  for ( const auto storage : { Reassembler::Storage::Map,
+                               Reassembler::Storage::Ring,
+                               Reassembler::Storage::Flat,
+                               Reassembler::Storage::Slices } ) {
+    speed_test( 1000, 1500, 1500, 32768, 1370, storage, "(no overlap):  " );
+    speed_test( 1000, 1500, 150, 32768, 6163, storage, "(10x overlap): " );
+  }
 }
 
 int main()
@@ -0,0 +1,59 @@
+#include "byte_stream_test_harness.hh"
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    for ( const auto storage : { Reassembler::Storage::Map,
+                                 Reassembler::Storage::Ring,
+                                 Reassembler::Storage::Flat,
+                                 Reassembler::Storage::Slices } ) {
+      ReassemblerTestHarness test { "stats", 8, storage };
+
+      test.execute( Insert { "b", 1 } );
+      test.execute( Holes { 1 } );
+      test.execute( MaxOutOfOrderDistance { 1 } );
+
+      test.execute( Insert { "d", 3 } );
+      test.execute( Holes { 2 } );
+      test.execute( MaxOutOfOrderDistance { 3 } );
+      test.execute( Merges { 0 } );
+
+      test.execute( Insert { "c", 2 } );
+      test.execute( Holes { 1 } );
+      test.execute( Merges { 2 } );
+      test.execute( BytesPending { 3 } );
+
+      test.execute( Insert { "abcdefghijkl", 0 } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( Holes { 0 } );
+      test.execute( Merges { 3 } );
+      test.execute( BytesDiscarded { 4 } );
+      test.execute( DuplicateBytes { 3 } );
+
+      test.execute( Insert { "abc", 0 } );
+      test.execute( DuplicateBytes { 6 } );
+
+      test.execute( Insert { "z", 20 } );
+      test.execute( BytesDiscarded { 5 } );
+      test.execute( MaxOutOfOrderDistance { 12 } );
+
+      test.execute( ReadAll( "abcdefgh" ) );
+      test.execute( Insert { "ijkl", 8 } );
+      test.execute( Holes { 0 } );
+      test.execute( DuplicateBytes { 6 } );
+      test.execute( BytesDiscarded { 5 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include "reassembler.hh"
+
+#include <array>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The first few stored runs, as [start, end) pairs
+vector<pair<uint64_t, uint64_t>> blocks( const Reassembler& r )
+{
+  array<Reassembler::Block, 4> blocks {};
+  vector<pair<uint64_t, uint64_t>> ret;
+  const size_t filled = r.received_blocks( blocks );
+  for ( size_t i = 0; i < filled; ++i ) {
+    ret.emplace_back( blocks.at( i ).start, blocks.at( i ).end );
+  }
+  return ret;
+}
+
+// Feed the same random, overlapping, out-of-order segments to a map-backed Reassembler and one using
+// `storage` (optionally both with pending limits), and check that the two agree on everything observable
+// after every step.
+void differential_test( const Reassembler::Storage storage,
+                        const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                        const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                        const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                        ByteStream::Storage stream_storage,
+                        bool limited = false )
+{
+  default_random_engine rd { random_seed };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  Reassembler expected { ByteStream { capacity, stream_storage } };
+  Reassembler actual { ByteStream { capacity, stream_storage }, storage };
+  string expected_output;
+  string actual_output;
+  if ( limited ) {
+    expected.set_pending_limits( capacity / 2, 3 );
+    actual.set_pending_limits( capacity / 2, 3 );
+  }
+
+  const auto check = [&]( const string& step ) {
+    const auto expected_stats = expected.stats();
+    const auto actual_stats = actual.stats();
+    if ( expected.writer().bytes_pushed() != actual.writer().bytes_pushed()
+         or expected.count_bytes_pending() != actual.count_bytes_pending()
+         or expected_stats.holes != actual_stats.holes or expected_stats.merges != actual_stats.merges
+         or expected_stats.duplicate_bytes != actual_stats.duplicate_bytes
+         or expected_stats.bytes_discarded != actual_stats.bytes_discarded
+         or expected_stats.bytes_pruned != actual_stats.bytes_pruned
+         or blocks( expected ) != blocks( actual )
+         or expected.writer().is_closed() != actual.writer().is_closed() or expected_output != actual_output ) {
+      throw runtime_error( "Reassembler storage " + to_string( static_cast<int>( storage ) )
+                           + " disagrees with map storage after " + step + " (input=" + to_string( input_len )
+                           + ", capacity=" + to_string( capacity ) + ", seed=" + to_string( random_seed ) + ")" );
+    }
+  };
+
+  uniform_int_distribution<size_t> segment_len { 0, capacity * 2 };
+  uniform_int_distribution<size_t> read_len { 0, capacity };
+  while ( not expected.reader().is_finished() ) {
+    // Mostly segments near the front of the window, some beyond it, a few behind it
+    const uint64_t next = expected.writer().bytes_pushed();
+    uniform_int_distribution<uint64_t> first_index { next > capacity ? next - capacity : 0, next + capacity * 2 };
+    const uint64_t index = min( static_cast<uint64_t>( data.size() ), first_index( rd ) );
+    const string segment = data.substr( index, segment_len( rd ) );
+    const bool last = index + segment.size() == data.size();
+    expected.insert( index, segment, last );
+    actual.insert( index, segment, last );
+    check( "insert of " + to_string( segment.size() ) + " bytes @ " + to_string( index ) );
+
+    const size_t len = read_len( rd );
+    string chunk;
+    read( expected.reader(), len, chunk );
+    expected_output += chunk;
+    read( actual.reader(), len, chunk );
+    actual_output += chunk;
+    check( "read of " + to_string( len ) + " bytes" );
+  }
+
+  if ( expected_output.size() != data.size() or not actual.reader().is_finished() ) {
+    throw runtime_error( "Reassembler storage test did not finish the stream" );
+  }
+}
+
+int main()
+{
+  try {
+    for ( const auto storage :
+          { Reassembler::Storage::Ring, Reassembler::Storage::Flat, Reassembler::Storage::Slices } ) {
+      for ( const auto stream_storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+        differential_test( storage, 1000, 1, 101, stream_storage );
+        differential_test( storage, 10000, 17, 202, stream_storage );
+        differential_test( storage, 50000, 64, 303, stream_storage );
+        differential_test( storage, 50000, 1000, 404, stream_storage );
+        differential_test( storage, 100000, 4096, 505, stream_storage );
+        differential_test( storage, 30000, 1000, 606, stream_storage, true );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -4,8 +4,10 @@
 #include "helpers.hh"
 #include "reassembler.hh"
 
+#include <algorithm>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<ByteStream>> T>
 struct ReassemblerTestStep : public TestStep<Reassembler>
@@ -31,6 +33,20 @@ public:
                    { Reassembler { ByteStream { capacity } } } )
   {}
 
+  ReassemblerTestHarness( std::string test_name, uint64_t capacity, Reassembler::Storage storage )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + storage_description( storage ),
+                   { Reassembler { ByteStream { capacity }, storage } } )
+  {}
+
+  static std::string storage_description( Reassembler::Storage storage )
+  {
+    if ( storage == Reassembler::Storage::Map ) {
+      return "";
+    }
+    return ", storage=" + std::string { Reassembler::storage_name( storage ) };
+  }
+
   template<std::derived_from<TestStep<ByteStream>> T>
   void execute( const T& test )
   {
@@ -47,6 +63,109 @@ struct BytesPending : public ExpectNumber<Reassembler, uint64_t>
   uint64_t value( const Reassembler& r ) const override { return r.count_bytes_pending(); }
 };
 
+struct Holes : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().holes"; }
+  uint64_t value( const Reassembler& r ) const override { return r.stats().holes; }
+};
+
+struct MaxOutOfOrderDistance : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().max_out_of_order_distance"; }
+  uint64_t value( const Reassembler& r ) const override { return r.stats().max_out_of_order_distance; }
+};
+
+struct BytesDiscarded : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().bytes_discarded"; }
+  uint64_t value( const Reassembler& r ) const override { return r.stats().bytes_discarded; }
+};
+
+struct DuplicateBytes : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().duplicate_bytes"; }
+  uint64_t value( const Reassembler& r ) const override { return r.stats().duplicate_bytes; }
+};
+
+struct Merges : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().merges"; }
+  uint64_t value( const Reassembler& r ) const override { return r.stats().merges; }
+};
+
+struct Prunes : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().prunes"; }
+  uint64_t value( const Reassembler& r ) const override { return r.stats().prunes; }
+};
+
+struct BytesPruned : public ExpectNumber<Reassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "stats().bytes_pruned"; }
+  uint64_t value( const Reassembler& r ) const override { return r.stats().bytes_pruned; }
+};
+
+struct SetPendingLimits : public Action<Reassembler>
+{
+  uint64_t max_bytes_;
+  uint64_t max_runs_;
+
+  SetPendingLimits( uint64_t max_bytes, uint64_t max_runs ) : max_bytes_( max_bytes ), max_runs_( max_runs ) {}
+
+  std::string description() const override
+  {
+    return "set pending limits to " + std::to_string( max_bytes_ ) + " bytes in " + std::to_string( max_runs_ )
+           + " runs";
+  }
+
+  void execute( Reassembler& r ) const override { r.set_pending_limits( max_bytes_, max_runs_ ); }
+};
+
+struct ReceivedBlocks : public Expectation<Reassembler>
+{
+  std::vector<Reassembler::Block> blocks_;
+  size_t max_blocks_;
+
+  ReceivedBlocks( std::vector<Reassembler::Block> blocks, size_t max_blocks = 4 )
+    : blocks_( std::move( blocks ) ), max_blocks_( max_blocks )
+  {}
+
+  static std::string describe( const std::vector<Reassembler::Block>& blocks )
+  {
+    std::ostringstream ss;
+    ss << "[";
+    for ( const auto& b : blocks ) {
+      ss << " [" << b.start << ", " << b.end << ")";
+    }
+    ss << " ]";
+    return ss.str();
+  }
+
+  std::string description() const override
+  {
+    return "received_blocks (up to " + std::to_string( max_blocks_ ) + ") = " + describe( blocks_ );
+  }
+
+  void execute( const Reassembler& r ) const override
+  {
+    std::vector<Reassembler::Block> actual( max_blocks_ );
+    actual.resize( r.received_blocks( actual ) );
+    const bool same = std::ranges::equal(
+      actual, blocks_, []( const auto& a, const auto& b ) { return a.start == b.start and a.end == b.end; } );
+    if ( not same ) {
+      throw ExpectationViolation( "should have had received_blocks = " + describe( blocks_ )
+                                  + ", but instead it was " + describe( actual ) );
+    }
+  }
+};
+
 struct Insert : public Action<Reassembler>
 {
   std::string data_;
@@ -73,3 +192,31 @@ struct Insert : public Action<Reassembler>
 
   void execute( Reassembler& r ) const override { r.insert( first_index_, data_, is_last_substring_ ); }
 };
+
+struct InsertMany : public Action<Reassembler>
+{
+  std::vector<Reassembler::Substring> substrings_ {};
+
+  InsertMany& insert( std::string data, uint64_t first_index, bool is_last_substring = false )
+  {
+    substrings_.push_back( { first_index, move( data ), is_last_substring } );
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    std::ostringstream ss;
+    ss << "insert_many [";
+    for ( const auto& s : substrings_ ) {
+      ss << " \"" << pretty_print( s.data ) << "\" @ " << s.first_index << ( s.is_last_substring ? " (last)" : "" );
+    }
+    ss << " ]";
+    return ss.str();
+  }
+
+  void execute( Reassembler& r ) const override
+  {
+    auto substrings = substrings_;
+    r.insert_many( substrings );
+  }
+};
@@ -43,6 +43,20 @@ public:
                    { TCPReceiver { Reassembler { ByteStream { capacity } } } } )
   {}
 
+  TCPReceiverTestHarness( std::string test_name, uint64_t capacity, const std::shared_ptr<MemoryBudget>& budget )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ", memory budget=" + std::to_string( budget->limit() ),
+                   { TCPReceiver { Reassembler { budgeted_stream( capacity, budget ), budget } } } )
+  {}
+
+  static ByteStream budgeted_stream( uint64_t capacity, const std::shared_ptr<MemoryBudget>& budget )
+  {
+    ByteStream stream { capacity };
+    stream.set_memory_budget( budget );
+    return stream;
+  }
+
   template<std::derived_from<TestStep<Reassembler>> T>
   void execute( const T& test )
   {
@@ -108,6 +122,20 @@ struct ExpectAcknoBetween : public Expectation<TCPReceiver>
   }
 };
 
+struct ExpectFastPathHits : public ExpectNumber<TCPReceiver, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "fast_path_hits"; }
+  uint64_t value( const TCPReceiver& rs ) const override { return rs.fast_path_hits(); }
+};
+
+struct ExpectSegmentsReceived : public ExpectNumber<TCPReceiver, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "segments_received"; }
+  uint64_t value( const TCPReceiver& rs ) const override { return rs.segments_received(); }
+};
+
 struct HasAckno : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -0,0 +1,70 @@
+#include "byte_stream_test_harness.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+void expect_budget( const MemoryBudget& budget, uint64_t current, uint64_t peak )
+{
+  if ( budget.current() != current or budget.peak() != peak ) {
+    throw runtime_error( "MemoryBudget: expected current=" + to_string( current ) + " and peak="
+                         + to_string( peak ) + ", but found current=" + to_string( budget.current() )
+                         + " and peak=" + to_string( budget.peak() ) );
+  }
+}
+
+int main()
+{
+  try {
+    {
+      const size_t cap = 4000;
+      const uint32_t isn = 23452;
+      const auto budget = make_shared<MemoryBudget>( 10 );
+      TCPReceiverTestHarness test { "window shrinks to what is left of the memory budget", cap, budget };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectWindow { 10 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { 6 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { 2 } );
+      expect_budget( *budget, 8, 8 );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 13 } } );
+      test.execute( ExpectWindow { 0 } );
+      expect_budget( *budget, 12, 12 );
+      test.execute( ReadAll { "abcdefghijkl" } );
+      test.execute( ExpectWindow { 10 } );
+      expect_budget( *budget, 0, 12 );
+    }
+
+    {
+      const size_t cap = 4000;
+      const uint32_t isn = 1000;
+      const auto budget = make_shared<MemoryBudget>( 100 );
+      TCPReceiverTestHarness one { "receivers sharing a memory budget (one)", cap, budget };
+      TCPReceiverTestHarness two { "receivers sharing a memory budget (two)", cap, budget };
+      one.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      two.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      one.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 30, 'x' ) ) );
+      two.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 50, 'y' ) ) );
+      one.execute( ExpectWindow { 20 } );
+      two.execute( ExpectWindow { 20 } );
+      one.execute( ReadAll { string( 30, 'x' ) } );
+      two.execute( ExpectWindow { 50 } );
+      expect_budget( *budget, 50, 80 );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
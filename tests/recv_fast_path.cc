@@ -0,0 +1,85 @@
+#include "byte_stream_test_harness.hh"
+#include "random.hh"
+#include "reassembler_test_harness.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    /* in-order segments take the fast path */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "in-order segments take the fast path", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectFastPathHits { 0 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ExpectWindow { 3992 } );
+      test.execute( ExpectFastPathHits { 2 } );
+      test.execute( ExpectSegmentsReceived { 3 } );
+      test.execute( ReadAll { "abcdefgh" } );
+    }
+
+    /* reordering falls back to the Reassembler until nothing is pending */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "reordering falls back to the Reassembler", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( BytesPending { 4 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( BytesPending { 0 } );
+      test.execute( ExpectFastPathHits { 0 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectFastPathHits { 1 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 13 } } );
+      test.execute( ReadAll { "abcdefghijkl" } );
+    }
+
+    /* FIN, overflow and stale segments take the slow path */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "FIN, overflow and stale segments take the slow path", 4 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcdef" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "ef" ).with_fin() );
+      test.execute( ExpectAckno { Wrap32 { isn + 8 } } );
+      test.execute( ExpectFastPathHits { 0 } );
+      test.execute( ReadAll { "ef" } );
+      test.execute( IsFinished { true } );
+    }
+
+    /* the fast path closes the stream when an earlier FIN is reached */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "fast path closes the stream at an earlier FIN", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_fin() );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectFastPathHits { 1 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 6 } } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+    const uint16_t big_window = 60000;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "NewReno slow start, timeout and congestion avoidance", cfg };
+      const auto expect_segments = [&]( uint64_t first, uint64_t count ) {
+        for ( uint64_t i = 0; i < count; ++i ) {
+          test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno(
+            isn + 1 + static_cast<uint32_t>( first + i * mss ) ) );
+        }
+        test.execute( ExpectNoSegment {} );
+      };
+
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( big_window ) );
+      test.execute( ExpectCongestionWindow { 4 * mss } );
+      test.execute( ExpectSlowStartThreshold { UINT64_MAX } );
+
+      // The initial window is four segments, though the receiver's window is much larger
+      test.execute( Push { string( 10 * mss, 'a' ) } );
+      expect_segments( 0, 4 );
+
+      // Slow start: each ACK grows the window by up to one segment
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( mss ) }.with_win( big_window ) );
+      test.execute( ExpectCongestionWindow { 5 * mss } );
+      expect_segments( 4 * mss, 2 );
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( 4 * mss ) }.with_win( big_window ) );
+      test.execute( ExpectCongestionWindow { 6 * mss } );
+      expect_segments( 6 * mss, 4 );
+      test.execute( ExpectSeqnosInFlight { 6 * mss } );
+
+      // A timeout halves what was in flight for ssthresh, and the window falls to one segment
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute(
+        ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + static_cast<uint32_t>( 4 * mss ) ) );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectSlowStartThreshold { 3 * mss } );
+      test.execute( Push { string( 5 * mss, 'b' ) } );
+      test.execute( ExpectNoSegment {} );
+
+      // Slow start again up to ssthresh, then one segment more per window acknowledged
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( 10 * mss ) }.with_win( big_window ) );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+      expect_segments( 10 * mss, 2 );
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( 12 * mss ) }.with_win( big_window ) );
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+      expect_segments( 12 * mss, 3 );
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( 14 * mss ) }.with_win( big_window ) );
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( 15 * mss ) }.with_win( big_window ) );
+      test.execute( ExpectCongestionWindow { 4 * mss } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "NewReno respects the smaller receiver window", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1500 ) );
+      test.execute( Push { string( 10 * mss, 'a' ) } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 500 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "NewReno ignores timeouts while probing a zero window", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 0 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ) );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ) );
+      test.execute( ExpectCongestionWindow { 4 * mss } );
+      test.execute( ExpectSlowStartThreshold { UINT64_MAX } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
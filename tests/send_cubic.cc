@@ -0,0 +1,147 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+// Acknowledge a full window, a segment at a time, once per `rtt_ms`, for `duration_ms`
+void run( Cubic& cubic, uint64_t& now_ms, uint64_t rtt_ms, uint64_t duration_ms )
+{
+  cubic.on_rtt_sample( rtt_ms );
+  for ( const uint64_t end = now_ms + duration_ms; now_ms < end; now_ms += rtt_ms ) {
+    const uint64_t window = cubic.cwnd();
+    for ( uint64_t acked = 0; acked < window; acked += mss ) {
+      cubic.on_ack( mss, window, now_ms );
+    }
+  }
+}
+
+// A CUBIC flow that has slow-started to 100 segments and then lost one
+Cubic after_loss()
+{
+  Cubic cubic { mss };
+  while ( cubic.cwnd() < 100 * mss ) {
+    cubic.on_ack( mss, cubic.cwnd(), 0 );
+  }
+  cubic.on_loss( cubic.cwnd(), 0 );
+  return cubic;
+}
+
+void check( bool condition, const string& what, const Cubic& cubic )
+{
+  if ( !condition ) {
+    throw runtime_error( what + " (cwnd=" + to_string( cubic.cwnd() ) + ", ssthresh="
+                         + to_string( cubic.ssthresh() ) + ", w_max=" + to_string( cubic.w_max() ) + ")" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      // A loss cuts the window to 0.7 of what it was, which becomes W_max
+      Cubic cubic = after_loss();
+      check( cubic.cwnd() == 70 * mss, "loss should cut cwnd to 0.7 of it", cubic );
+      check( cubic.ssthresh() == 70 * mss, "ssthresh should be the cut window", cubic );
+      check( cubic.w_max() == 100 * mss, "W_max should be the window before the loss", cubic );
+
+      // Fast convergence: another loss before W_max is reached lowers W_max below the current window
+      cubic.on_loss( cubic.cwnd(), 0 );
+      check( cubic.w_max() == 59500, "fast convergence should set W_max to 0.85 of cwnd", cubic );
+      check( cubic.cwnd() == 49 * mss, "the second loss should cut cwnd to 0.7 again", cubic );
+
+      // A timeout also remembers W_max, but the window restarts from one segment
+      cubic.on_rto( cubic.cwnd(), 0 );
+      check( cubic.cwnd() == mss, "a timeout should drop cwnd to one segment", cubic );
+      check( cubic.ssthresh() == 34300, "a timeout should cut ssthresh to 0.7 of cwnd", cubic );
+    }
+
+    {
+      // Growth depends on time, not round trips: the window is back at W_max after about K seconds
+      // (K = cbrt(W_max (1 - β) / C) = 4.2 s here), whether the RTT is 100 ms or 300 ms
+      for ( const uint64_t rtt_ms : { 100, 300 } ) {
+        Cubic cubic = after_loss();
+        uint64_t now_ms = 0;
+        run( cubic, now_ms, rtt_ms, 2100 );
+        check( cubic.cwnd() > 90 * mss && cubic.cwnd() < 100 * mss,
+               "cwnd should approach W_max quickly, then flatten (RTT " + to_string( rtt_ms ) + " ms)",
+               cubic );
+        run( cubic, now_ms, rtt_ms, 2100 );
+        check( cubic.cwnd() > 98 * mss && cubic.cwnd() < 102 * mss,
+               "cwnd should be on the plateau around K (RTT " + to_string( rtt_ms ) + " ms)",
+               cubic );
+        run( cubic, now_ms, rtt_ms, 4200 );
+        check( cubic.cwnd() > 120 * mss,
+               "cwnd should probe beyond W_max ever faster (RTT " + to_string( rtt_ms ) + " ms)",
+               cubic );
+      }
+    }
+
+    {
+      // TCP-friendly region: at a short RTT, standard TCP would grow faster than W(t), and so does CUBIC
+      Cubic cubic = after_loss();
+      uint64_t now_ms = 0;
+      run( cubic, now_ms, 10, 2000 );
+      check( cubic.cwnd() > 150 * mss, "cwnd should grow as fast as standard TCP at a 10 ms RTT", cubic );
+    }
+
+    {
+      TCPConfig cfg;
+      auto rd = get_random_engine();
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+      TCPSenderTestHarness test { "CUBIC slow start, RTT sampling and timeout", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+      test.execute( ExpectSmoothedRTT { 40 } );
+      test.execute( ExpectCongestionWindow { 4 * mss } );
+
+      test.execute( Push { string( 10 * mss, 'a' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 80 } );
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( 2 * mss ) }.with_win( 60000 ) );
+      test.execute( ExpectSmoothedRTT { 45 } );
+      test.execute( ExpectCongestionWindow { 5 * mss } );
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectSeqnosInFlight { 5 * mss } );
+
+      // A timeout cuts ssthresh to 0.7 of the window and restarts from one segment
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute(
+        ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + static_cast<uint32_t>( 2 * mss ) ) );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectSlowStartThreshold { 3500 } );
+
+      // The retransmitted segment isn't timed, however long its ACK takes
+      test.execute( Tick { 500 } );
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( 3 * mss ) }.with_win( 60000 ) );
+      test.execute( ExpectSmoothedRTT { 45 } );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+    const uint16_t big_window = 60000;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "Fast retransmit and NewReno fast recovery", cfg };
+      const auto seqno = [&]( uint64_t offset ) { return isn + 1 + static_cast<uint32_t>( offset ); };
+      const auto expect_segment = [&]( uint64_t offset, uint64_t size ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( size ).with_seqno( seqno( offset ) ) );
+      };
+      const auto ack
+        = [&]( uint64_t offset ) { test.execute( AckReceived { seqno( offset ) }.with_win( big_window ) ); };
+
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      ack( 0 );
+      test.execute( Push { string( 10 * mss, 'a' ) } );
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        expect_segment( i * mss, mss );
+      }
+      ack( mss );
+      expect_segment( 4 * mss, mss );
+      expect_segment( 5 * mss, mss );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 5 * mss } );
+
+      // The segment at 1000 is lost: the three segments after it each bring a duplicate ACK
+      ack( mss );
+      ack( mss );
+      test.execute( ExpectNoSegment {} );
+      ack( mss );
+      expect_segment( mss, mss );
+      test.execute( ExpectSlowStartThreshold { 5 * mss / 2 } );
+      test.execute( ExpectCongestionWindow { 5 * mss / 2 } );
+      // ... and the window, inflated by those three segments, lets some new data out
+      expect_segment( 6 * mss, mss / 2 );
+      test.execute( ExpectNoSegment {} );
+
+      // Each further duplicate ACK lets one more segment in
+      ack( mss );
+      expect_segment( 6 * mss + mss / 2, mss );
+      test.execute( ExpectNoSegment {} );
+
+      // A partial ACK: the segment at 3000 was lost too, and is resent without waiting for the timer
+      ack( 3 * mss );
+      expect_segment( 3 * mss, mss );
+      expect_segment( 7 * mss + mss / 2, mss );
+      test.execute( ExpectNoSegment {} );
+
+      // The full ACK ends recovery, at ssthresh
+      ack( 8 * mss + mss / 2 );
+      test.execute( ExpectCongestionWindow { 5 * mss / 2 } );
+      expect_segment( 8 * mss + mss / 2, mss );
+      expect_segment( 9 * mss + mss / 2, mss / 2 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+
+      // Congestion avoidance from there
+      ack( 10 * mss );
+      test.execute( ExpectCongestionWindow { 5 * mss / 2 } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "Only duplicate ACKs count", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( Push { string( 4 * mss, 'a' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+
+      // A change of window makes an ACK a window update, not a duplicate
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5 * mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1 }.with_win( 5 * mss ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 5 * mss ) );
+      test.execute( ExpectNoSegment {} );
+
+      // Without congestion control, the third still resends the segment
+      test.execute( AckReceived { isn + 1 }.with_win( 5 * mss ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "ACKs on the peer's data segments aren't duplicates", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( Push { string( 4 * mss, 'a' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+
+      // Traffic the other way carries the same ackno and window without anything having been lost
+      for ( int i = 0; i < 5; ++i ) {
+        test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ).with_data() );
+      }
+      test.execute( ExpectNoSegment {} );
+
+      // ... nor does it break a run of real duplicates
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ).with_data() );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "No fast retransmit for what a timeout already resent", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( Push { string( 4 * mss, 'a' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+
+      // Late duplicates of the ACK from before the timeout
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "No fast recovery on duplicate ACKs at the timeout's recover point", cfg };
+      const auto seqno = [&]( uint64_t offset ) { return isn + 1 + static_cast<uint32_t>( offset ); };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { seqno( 0 ) }.with_win( big_window ) );
+      test.execute( Push { string( 4 * mss, 'a' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( seqno( 0 ) ) );
+      test.execute( ExpectSlowStartThreshold { 2 * mss } );
+
+      // Everything sent before the timeout is acknowledged, exactly up to `recover`
+      test.execute( AckReceived { seqno( 4 * mss ) }.with_win( big_window ) );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+      test.execute( Push { string( 2 * mss, 'b' ) } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( seqno( 4 * mss ) ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( seqno( 5 * mss ) ) );
+
+      // RFC 6582 needs the ACK to be past `recover` to start fast recovery again
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { seqno( 4 * mss ) }.with_win( big_window ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSlowStartThreshold { 2 * mss } );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Duplicate ACKs are ignored unless fast retransmit is on", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( Push { string( 4 * mss, 'a' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      for ( int i = 0; i < 5; ++i ) {
+        test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
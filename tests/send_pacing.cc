@@ -0,0 +1,138 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = true;
+
+      TCPSenderTestHarness test { "Paced sender sends nothing on tick() before push()", cfg };
+      test.execute( Tick { 1 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = true;
+      cfg.pacing_burst = 2;
+
+      TCPSenderTestHarness test { "Pacing spreads a window over the RTT", cfg };
+      const auto expect_segment = [&]( uint64_t n ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno(
+          isn + 1 + static_cast<uint32_t>( n * mss ) ) );
+      };
+
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 10 * mss ) );
+      test.execute( ExpectSmoothedRTT { 100 } );
+
+      // 10 segments per 100 ms, at 1.2 times that: one every 8.33 ms, after a burst of two
+      test.execute( Push { string( 20 * mss, 'a' ) } );
+      expect_segment( 0 );
+      expect_segment( 1 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 8 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      expect_segment( 2 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 8 } );
+      expect_segment( 3 );
+      test.execute( Tick { 7 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      expect_segment( 4 );
+      test.execute( ExpectSeqnosInFlight { 5 * mss } );
+
+      // Time spent with nothing to send doesn't add up to more than the burst
+      test.execute( Tick { 100 } );
+      expect_segment( 5 );
+      expect_segment( 6 );
+      test.execute( ExpectNoSegment {} );
+
+      // Once the window is full, ACKs release segments at the pace too
+      for ( uint64_t n = 7; n < 10; ++n ) {
+        test.execute( Tick { 9 } );
+        expect_segment( n );
+      }
+      test.execute( Tick { 100 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1 + static_cast<uint32_t>( 5 * mss ) }.with_win( 10 * mss ) );
+      expect_segment( 10 );
+      expect_segment( 11 );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = true;
+      cfg.pacing_burst = 2;
+
+      TCPSenderTestHarness test { "Pacing waits for an RTT sample", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( Push { string( 10 * mss, 'a' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = true;
+      cfg.pacing_burst = 1;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "Pacing runs at twice the window per RTT in slow start", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 80 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+
+      // Four segments per 80 ms, doubled: one every 10 ms
+      test.execute( Push { string( 10 * mss, 'a' ) } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 9 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <exception>
 #include <iostream>
+#include <memory>
 #include <string>
 
 using namespace std;
@@ -165,6 +166,50 @@ int main()
       test.execute( ExpectSeqno { Wrap32 { isn + 1 + 3 } } );
     }
 
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.send_capacity = 1500;
+
+      // The second write wraps around the end of the outbound ring buffer
+      const string first = string( 1000, 'a' ) + string( 200, 'b' );
+      const string second = string( 300, 'c' ) + string( 700, 'd' );
+      TCPSenderTestHarness test { "Segment spans the end of the outbound ring", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push( first ) );
+      test.execute( ExpectMessage {}.with_data( first.substr( 0, 1000 ) ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push( second ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 1000 } }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( first.substr( 1000 ) + second.substr( 0, 800 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 2000 } }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( second.substr( 800 ) ).with_seqno( isn + 1 + 2000 ) );
+      test.execute( ExpectSeqnosInFlight { 200 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.buffer_pool = make_shared<BufferPool>( 64 );
+
+      // The paged outbound stream keeps these bytes on two pages
+      const string data = string( 64, 'x' ) + string( 36, 'y' );
+      TCPSenderTestHarness test { "Segment spans a page boundary", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push( data ) );
+      test.execute( ExpectMessage {}.with_data( data ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 100 } );
+    }
+
   } catch ( const exception& e ) {
     cerr << e.what() << "\n";
     return 1;
@@ -55,9 +55,23 @@ public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ) + " and ISN=" + to_string( config.isn ),
-                   { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
+                   { make_sender( config ) } )
   {}
 
+  static TCPSender make_sender( const TCPConfig& config )
+  {
+    TCPSender sender { config.buffer_pool ? ByteStream { config.send_capacity, config.buffer_pool }
+                                          : ByteStream { config.send_capacity },
+                       config.isn,
+                       config.rt_timeout,
+                       CongestionControl::make( config.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE ) };
+    if ( config.pacing ) {
+      sender.set_pacing( config.pacing_burst );
+    }
+    sender.set_fast_retransmit( config.fast_retransmit );
+    return sender;
+  }
+
   template<std::derived_from<TestStep<TCPSender>> T>
   void execute( const T& test )
   {
@@ -104,6 +118,27 @@ struct ExpectConsecutiveRetransmissions : public ExpectNumber<TCPSender, uint64_
   uint64_t value( const TCPSender& sender ) const override { return sender.consecutive_retransmissions(); }
 };
 
+struct ExpectCongestionWindow : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_control()->cwnd()"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.congestion_control()->cwnd(); }
+};
+
+struct ExpectSlowStartThreshold : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_control()->ssthresh()"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.congestion_control()->ssthresh(); }
+};
+
+struct ExpectSmoothedRTT : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "smoothed_rtt_ms"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.smoothed_rtt_ms().value_or( 0 ); }
+};
+
 struct ExpectNoSegment : public Expectation<SenderAndOutput>
 {
   std::string description() const override { return "nothing to send"; }
@@ -216,13 +251,18 @@ struct Tick : public Action<SenderAndOutput>
 struct Receive : public Action<SenderAndOutput>
 {
   TCPReceiverMessage msg_;
+  bool with_data_ = false;
   bool push_ = true;
 
   explicit Receive( TCPReceiverMessage msg ) : msg_( msg ) {}
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    if ( with_data_ ) {
+      desc << ", on a data segment";
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push";
     }
@@ -235,9 +275,15 @@ struct Receive : public Action<SenderAndOutput>
     return *this;
   }
 
+  Receive& with_data()
+  {
+    with_data_ = true;
+    return *this;
+  }
+
   void execute( SenderAndOutput& ss ) const override
   {
-    ss.sender.receive( msg_ );
+    ss.sender.receive( msg_, with_data_ );
     if ( push_ ) {
       ss.sender.push( ss.make_transmit() );
     }
@@ -0,0 +1,92 @@
+#include "conversions.hh"
+#include "random.hh"
+#include "wrapping_integers.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// wrap and unwrap are usable at compile time
+static_assert( Wrap32::wrap( 3, Wrap32 { UINT32_MAX } ) == Wrap32 { 2 } );
+static_assert( Wrap32 { 1 }.unwrap( Wrap32 { 0 }, UINT32_MAX ) == ( uint64_t { 1 } << 32 ) + 1 );
+static_assert( Wrap32 { 15 }.unwrap( Wrap32 { 16 }, 0 ) == UINT32_MAX );
+
+// The closest of the three candidates around the checkpoint's 2^32 block, preferring the one inside it
+uint64_t reference_unwrap( uint32_t raw, uint32_t zero_point, uint64_t checkpoint )
+{
+  const uint64_t one_wrap = uint64_t { 1 } << 32;
+  const uint64_t block = checkpoint >> 32 << 32;
+  const uint64_t in_block = block + static_cast<uint32_t>( raw - zero_point );
+  const auto distance = [&]( uint64_t n ) { return n > checkpoint ? n - checkpoint : checkpoint - n; };
+  uint64_t best = in_block;
+  if ( in_block >= one_wrap && distance( in_block - one_wrap ) < distance( best ) ) {
+    best = in_block - one_wrap;
+  }
+  if ( distance( in_block + one_wrap ) < distance( best ) ) {
+    best = in_block + one_wrap;
+  }
+  return best;
+}
+
+void check_batch( const vector<uint32_t>& raws, uint32_t zero_point, uint64_t checkpoint )
+{
+  vector<Wrap32> seqnos;
+  for ( const auto raw : raws ) {
+    seqnos.emplace_back( raw );
+  }
+  vector<uint64_t> unwrapped( seqnos.size() );
+  Wrap32::unwrap_many( seqnos, Wrap32 { zero_point }, checkpoint, unwrapped );
+
+  vector<Wrap32> rewrapped( unwrapped.size(), Wrap32 { 0 } );
+  Wrap32::wrap_many( unwrapped, Wrap32 { zero_point }, rewrapped );
+
+  for ( size_t i = 0; i < raws.size(); ++i ) {
+    const uint64_t expected = reference_unwrap( raws[i], zero_point, checkpoint );
+    if ( unwrapped[i] != expected or seqnos[i].unwrap( Wrap32 { zero_point }, checkpoint ) != expected
+         or not( rewrapped[i] == seqnos[i] ) ) {
+      ostringstream ss;
+      ss << "Batch unwrap of " << raws[i] << " with zero point " << zero_point << " and checkpoint "
+         << checkpoint << " gave " << unwrapped[i] << " (expected " << expected << ")";
+      throw runtime_error( ss.str() );
+    }
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    uniform_int_distribution<uint32_t> dist32 { 0, numeric_limits<uint32_t>::max() };
+    uniform_int_distribution<uint64_t> dist63 { 0, uint64_t { 1 } << 63 };
+    uniform_int_distribution<size_t> batch_size { 0, 100 };
+
+    // Ties: exactly 2^31 above and below the checkpoint, in each half of its block
+    for ( const uint64_t checkpoint : { uint64_t { 0 },
+                                        uint64_t { 1 } << 31,
+                                        uint64_t { 1 } << 32,
+                                        ( uint64_t { 3 } << 31 ) + 7,
+                                        ( uint64_t { 5 } << 32 ) + 7 } ) {
+      const auto low = static_cast<uint32_t>( checkpoint );
+      check_batch( { low + ( 1U << 31 ), low, low + 1, low - 1, low + ( 1U << 31 ) - 1, low + ( 1U << 31 ) + 1 },
+                   0,
+                   checkpoint );
+    }
+
+    for ( unsigned int i = 0; i < 10000; i++ ) {
+      vector<uint32_t> raws( batch_size( rd ) );
+      ranges::generate( raws, [&] { return dist32( rd ); } );
+      const uint64_t checkpoint = i % 2 ? dist63( rd ) : dist32( rd );
+      check_batch( raws, dist32( rd ), checkpoint );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+#include "wrapping_integers.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * Wrap32 microbenchmark: nanoseconds per wrap or unwrap.
+ *
+ * A trace of sequence numbers (a random walk forward, as segments and ACKs would be seen) is unwrapped
+ * one at a time against a checkpoint that follows the trace (as TCPReceiver and TCPSender do), in
+ * batches with unwrap_many(), and with the three-candidate unwrap this replaced; it is wrapped again
+ * one at a time and with wrap_many(). One row per case is printed as CSV (default) or JSON (--json).
+ */
+
+namespace {
+
+constexpr size_t trace_length = size_t { 1 } << 20;
+constexpr size_t batch_size = 1024;
+constexpr int repetitions = 20;
+
+uint64_t three_candidates( uint32_t raw, uint32_t zero_point, uint64_t checkpoint )
+{
+  uint64_t result = ( checkpoint >> 32 << 32 ) + raw - zero_point;
+  if ( raw < zero_point )
+    result += 1ULL << 32;
+  const uint64_t below = result - ( 1ULL << 32 );
+  const uint64_t above = result + ( 1ULL << 32 );
+  if ( result >= ( 1ULL << 32 )
+       && min( below - checkpoint, checkpoint - below ) < min( result - checkpoint, checkpoint - result ) )
+    result = below;
+  if ( min( above - checkpoint, checkpoint - above ) < min( result - checkpoint, checkpoint - result ) )
+    result = above;
+  return result;
+}
+
+// Run `body` (which handles the whole trace) a few times; return ns per element
+double time_per_element( const function<void()>& body )
+{
+  const auto start_time = steady_clock::now();
+  for ( int i = 0; i < repetitions; ++i ) {
+    body();
+  }
+  const auto stop_time = steady_clock::now();
+  return duration_cast<duration<double, nano>>( stop_time - start_time ).count() / repetitions / trace_length;
+}
+
+void program_body( bool json )
+{
+  default_random_engine rd { 31415 };
+  const Wrap32 isn { uniform_int_distribution<uint32_t> {}( rd ) };
+
+  // Absolute sequence numbers stepping forward by up to a segment, starting just below a wrap
+  vector<uint64_t> absolute( trace_length );
+  uniform_int_distribution<uint64_t> step { 0, 1460 };
+  uint64_t n = ( uint64_t { 1 } << 32 ) - trace_length * 300;
+  for ( auto& a : absolute ) {
+    a = n;
+    n += step( rd );
+  }
+  vector<Wrap32> seqnos( trace_length, Wrap32 { 0 } );
+  Wrap32::wrap_many( absolute, isn, seqnos );
+  // The raw values, for the three-candidate unwrap (unwrapping against a zero point of 0 reveals them)
+  vector<uint32_t> raws( trace_length );
+  for ( size_t i = 0; i < trace_length; ++i ) {
+    raws[i] = static_cast<uint32_t>( Wrap32::wrap( absolute[i], isn ).unwrap( Wrap32 { 0 }, 0 ) );
+  }
+  const uint32_t zero_raw = static_cast<uint32_t>( isn.unwrap( Wrap32 { 0 }, 0 ) );
+
+  vector<uint64_t> unwrapped( trace_length );
+  vector<Wrap32> wrapped( trace_length, Wrap32 { 0 } );
+
+  const auto verify = [&] {
+    if ( unwrapped != absolute ) {
+      throw runtime_error( "unwrap did not recover the trace" );
+    }
+  };
+
+  const vector<pair<string, function<void()>>> cases {
+    { "unwrap",
+      [&] {
+        uint64_t checkpoint = absolute.front();
+        for ( size_t i = 0; i < trace_length; ++i ) {
+          checkpoint = seqnos[i].unwrap( isn, checkpoint );
+          unwrapped[i] = checkpoint;
+        }
+      } },
+    { "unwrap_three_candidates",
+      [&] {
+        uint64_t checkpoint = absolute.front();
+        for ( size_t i = 0; i < trace_length; ++i ) {
+          checkpoint = three_candidates( raws[i], zero_raw, checkpoint );
+          unwrapped[i] = checkpoint;
+        }
+      } },
+    { "unwrap_many",
+      [&] {
+        // Each batch is unwrapped against the last value of the one before
+        uint64_t checkpoint = absolute.front();
+        for ( size_t i = 0; i < trace_length; i += batch_size ) {
+          const span<uint64_t> out { unwrapped.data() + i, batch_size };
+          Wrap32::unwrap_many( span { seqnos }.subspan( i, batch_size ), isn, checkpoint, out );
+          checkpoint = out.back();
+        }
+      } },
+    { "wrap",
+      [&] {
+        for ( size_t i = 0; i < trace_length; ++i ) {
+          wrapped[i] = Wrap32::wrap( absolute[i], isn );
+        }
+      } },
+    { "wrap_many",
+      [&] {
+        Wrap32::wrap_many( absolute, isn, wrapped );
+      } },
+  };
+
+  if ( json ) {
+    cout << "[\n";
+  } else {
+    cout << "case,elements,ns_per_element\n";
+  }
+
+  bool first = true;
+  for ( const auto& [name, body] : cases ) {
+    ranges::fill( unwrapped, 0 );
+    const double ns = time_per_element( body );
+    if ( name.starts_with( "unwrap" ) ) {
+      verify();
+    } else if ( wrapped != seqnos ) {
+      throw runtime_error( "wrap did not reproduce the trace" );
+    }
+
+    ostringstream row;
+    row << fixed << setprecision( 3 );
+    if ( json ) {
+      row << ( first ? "  " : ", " ) << "{\"case\": \"" << name << "\", \"elements\": " << trace_length
+          << ", \"ns_per_element\": " << ns << "}\n";
+    } else {
+      row << name << "," << trace_length << "," << ns << "\n";
+    }
+    cout << row.str() << flush;
+    first = false;
+  }
+
+  if ( json ) {
+    cout << "]\n";
+  }
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    const bool json = argc > 1 and string_view { argv[1] } == "--json"; // NOLINT(*-pointer-arithmetic)
+    program_body( json );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
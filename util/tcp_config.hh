@@ -1,10 +1,14 @@
 #pragma once
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 
 //! Config for TCP sender and receiver
 class TCPConfig
@@ -19,6 +23,36 @@ public:
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
   Wrap32 isn { 137 };                      //!< Default initial sequence number
+
+  //! How the inbound stream buffers bytes; Chunked keeps each received payload without copying it, at the cost
+  //! of a queue node and a string per segment (which MemoryBudget doesn't charge)
+  ByteStream::Storage recv_storage = ByteStream::Storage::Ring;
+
+  //! How the Reassembler holds out-of-order bytes; the ring avoids per-segment allocation under heavy reordering
+  Reassembler::Storage reassembler_storage = Reassembler::Storage::Map;
+
+  //! Caps on the out-of-order bytes the Reassembler holds (and the separate runs they form), independent of
+  //! recv_capacity; beyond them, the bytes farthest ahead are dropped
+  uint64_t reassembly_max_bytes = UINT64_MAX;
+  uint64_t reassembly_max_runs = UINT64_MAX;
+
+  //! How the sender limits what it has in flight beyond the receiver's window (by default, it doesn't)
+  CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;
+
+  //! If set, the sender spreads its segments over the RTT instead of sending a window at once, with at most
+  //! pacing_burst segments back to back (see TCPSender::set_pacing)
+  bool pacing = false;
+  uint64_t pacing_burst = 2;
+
+  //! If set, the sender resends a segment after three duplicate ACKs, and recovers as NewReno does
+  bool fast_retransmit = false;
+
+  //! If set, both streams borrow their storage from this pool (ByteStream::Storage::Paged) instead
+  std::shared_ptr<BufferPool> buffer_pool {};
+
+  //! If set, the bytes buffered by both streams and the Reassembler are charged to this budget, and the
+  //! advertised receive window shrinks to what is left of it
+  std::shared_ptr<MemoryBudget> memory_budget {};
 };
 
 //! Config for classes derived from FdAdapter
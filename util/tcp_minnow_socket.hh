@@ -91,6 +91,8 @@ private:
 
   bool _outbound_shutdown { false }; //!< Has the owner shut down the outbound data to the TCP connection?
 
+  bool _outbound_full { false }; //!< Is the outbound stream above its high watermark (not yet drained to low)?
+
   bool _fully_acked { false }; //!< Has the outbound data been fully acknowledged by the peer?
 };
 
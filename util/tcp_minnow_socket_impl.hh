@@ -61,6 +61,12 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
 {
   _tcp.emplace( config );
 
+  // Pause the application at a full send buffer and resume at half full, so each read fills half of it
+  _tcp->outbound_writer().set_watermarks( config.send_capacity / 2,
+                                          config.send_capacity,
+                                          [&] { _outbound_full = false; },
+                                          [&] { _outbound_full = true; } );
+
   // Set up the event loop
 
   // There are three events to handle:
@@ -100,13 +106,9 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     _thread_data,
     Direction::In,
     [&] {
-      std::string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
+      _tcp->outbound_writer().read_from( _thread_data );
 
-      if ( _thread_data.eof() ) {
-        _tcp->outbound_writer().close();
+      if ( _tcp->outbound_writer().is_closed() ) {
         _outbound_shutdown = true;
 
         // debugging output:
@@ -119,8 +121,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
     },
     [&] {
-      return ( _tcp->active() ) and ( not _outbound_shutdown )
-             and ( _tcp->outbound_writer().available_capacity() > 0 );
+      return ( _tcp->active() ) and ( not _outbound_shutdown ) and ( not _outbound_full );
     },
     [&] {
       _tcp->outbound_writer().close();
@@ -141,11 +142,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       // Write from the inbound_stream into
       // the pipe, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
-      if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
-        inbound.pop( bytes_written );
-      }
+      inbound.write_to( _thread_data );
 
       if ( inbound.is_finished() or inbound.has_error() ) {
         _thread_data.shutdown( SHUT_WR );
@@ -57,7 +57,8 @@ public:
     time_of_last_receipt_ = cumulative_time_;
 
     // If SenderMessage occupies a sequence number, make sure to reply.
-    need_send_ |= ( msg.sender->sequence_length() > 0 );
+    const bool with_data = msg.sender->sequence_length() > 0;
+    need_send_ |= with_data;
 
     // If SenderMessage is a "keep-alive" (with intentionally invalid seqno), make sure to reply.
     // (N.B. orthodox TCP rules require a reply on any unacceptable segment.)
@@ -68,7 +69,8 @@ public:
     receiver_.receive( std::move( msg.sender ) );
 
     // Give incoming TCPReceiverMessage to sender.
-    sender_.receive( msg.receiver );
+    // (An ACK on a segment that occupies sequence numbers is never a duplicate ACK.)
+    sender_.receive( msg.receiver, with_data );
 
     // Send reply if needed.
     push( transmit );
@@ -88,8 +90,37 @@ public:
 
 private:
   TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+  TCPSender sender_ { make_sender() };
+  TCPReceiver receiver_ { make_reassembler() };
+
+  ByteStream make_stream( uint64_t capacity, ByteStream::Storage storage ) const
+  {
+    ByteStream stream
+      = cfg_.buffer_pool ? ByteStream { capacity, cfg_.buffer_pool } : ByteStream { capacity, storage };
+    stream.set_memory_budget( cfg_.memory_budget );
+    return stream;
+  }
+
+  TCPSender make_sender() const
+  {
+    TCPSender sender { make_stream( cfg_.send_capacity, ByteStream::Storage::Ring ),
+                       cfg_.isn,
+                       cfg_.rt_timeout,
+                       CongestionControl::make( cfg_.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE ) };
+    if ( cfg_.pacing ) {
+      sender.set_pacing( cfg_.pacing_burst );
+    }
+    sender.set_fast_retransmit( cfg_.fast_retransmit );
+    return sender;
+  }
+
+  Reassembler make_reassembler() const
+  {
+    Reassembler reassembler {
+      make_stream( cfg_.recv_capacity, cfg_.recv_storage ), cfg_.reassembler_storage, cfg_.memory_budget };
+    reassembler.set_pending_limits( cfg_.reassembly_max_bytes, cfg_.reassembly_max_runs );
+    return reassembler;
+  }
 
   bool need_send_ {};
 